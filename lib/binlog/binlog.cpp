@@ -0,0 +1,46 @@
+#include "binlog.h"
+
+uart_base_t* binlog_t::_uart = nullptr;
+volatile uint32_t binlog_t::_dropped = 0;
+
+/**
+ * Encoder target on the stack, to frame the record before masking interrupts.
+ */
+class binlog_out_t {
+private:
+    uint8_t* _buf;
+    uint32_t _len;
+    uint32_t _max;
+
+public:
+    binlog_out_t(uint8_t* buf, uint32_t max) : _buf(buf), _len(0), _max(max) { }
+
+    inline uint32_t writable() const { return _max - _len; }
+    inline uint32_t write(const void* buf, uint32_t len) {
+        memcpy(_buf + _len, buf, len);
+        _len += len;
+        return len;
+    }
+
+    /* get the length of the frame. */
+    inline uint32_t length() const { return _len; }
+};
+
+void binlog_t::send(const uint8_t* buf, uint32_t len) {
+    uint8_t frame[frame_t::bound(frame_t::COBS, 6 + BINLOG_MAX_ARGS)];
+    binlog_out_t out(frame, sizeof(frame));
+
+    frame_t::encode(out, frame_t::COBS, buf, len);
+    uint32_t n = out.length();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // --> the whole frame in one write, or nothing: a cut frame is lost anyway.
+    uart_base_t* uart = _uart;
+    if (uart && (uart->writable() < n || uart->write(frame, n) != n)) {
+        _dropped = _dropped + 1;
+    }
+
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,208 @@
+#ifndef __BINLOG_H__
+#define __BINLOG_H__
+
+#include "../uart/uart.h"
+#include "../frame/frame.h"
+
+#if !UART_USE_RING
+#error "binlog requires UART_USE_RING = 1."
+#endif
+
+/**
+ * binlog configurations.
+ * 1. BINLOG_LEVEL : lowest level to compile. (0: error, 1: warn, 2: info, 3: debug)
+ * 2. BINLOG_MAX_ARGS : max bytes of serialized arguments per record, the rest are cut.
+ * 3. BINLOG_USE_TICK : set 1 to put `HAL_GetTick()` in each record.
+ */
+#ifndef BINLOG_LEVEL
+#define BINLOG_LEVEL        2
+#endif
+
+#ifndef BINLOG_MAX_ARGS
+#define BINLOG_MAX_ARGS     48
+#endif
+
+#ifndef BINLOG_USE_TICK
+#define BINLOG_USE_TICK     1
+#endif
+
+// --> format strings are placed here, and the offset in this section is the format ID.
+//   : `binlog.py` reads this section from the ELF.
+#define BINLOG_SECTION      "binlog_fmt"
+
+#define BINLOG_STR2(x)      #x
+#define BINLOG_STR(x)       BINLOG_STR2(x)
+
+/**
+ * emit a record. the format string is stored as "<level>|<file>:<line>|<format>".
+ * note that, arguments are not formatted here. see `binlog_t::put` for types.
+ */
+#define BINLOG(level, fmt, ...) \
+    do { \
+        static const char _binlog_fmt[] __attribute__((section(BINLOG_SECTION), used)) \
+            = #level "|" __FILE__ ":" BINLOG_STR(__LINE__) "|" fmt; \
+        binlog_t::emit(_binlog_fmt, ##__VA_ARGS__); \
+    } while(0)
+
+#if BINLOG_LEVEL >= 0
+#define BINLOG_ERROR(fmt, ...)  BINLOG(E, fmt, ##__VA_ARGS__)
+#else
+#define BINLOG_ERROR(fmt, ...)  do { } while(0)
+#endif
+
+#if BINLOG_LEVEL >= 1
+#define BINLOG_WARN(fmt, ...)   BINLOG(W, fmt, ##__VA_ARGS__)
+#else
+#define BINLOG_WARN(fmt, ...)   do { } while(0)
+#endif
+
+#if BINLOG_LEVEL >= 2
+#define BINLOG_INFO(fmt, ...)   BINLOG(I, fmt, ##__VA_ARGS__)
+#else
+#define BINLOG_INFO(fmt, ...)   do { } while(0)
+#endif
+
+#if BINLOG_LEVEL >= 3
+#define BINLOG_DEBUG(fmt, ...)  BINLOG(D, fmt, ##__VA_ARGS__)
+#else
+#define BINLOG_DEBUG(fmt, ...)  do { } while(0)
+#endif
+
+// --> start of the format section, defined by the linker.
+extern "C" const char __start_binlog_fmt[];
+
+/**
+ * Tokenized logger on the UART TX queue.
+ * a record is: [format ID: 2 bytes, LE] [tick: 4 bytes, LE] [arguments...], and COBS-framed.
+ * if arguments do not fit in BINLOG_MAX_ARGS, the record ends at the last whole argument,
+ * and bit 15 of the format ID is set. (so the format section must be less than 32 KB)
+ * --
+ * argument encoding (little endian, follows the C default argument promotion):
+ *  integers up to 32 bits --> 4 bytes, 64-bit integers --> 8 bytes,
+ *  float and double --> 4 bytes (float), pointers --> 4 bytes,
+ *  strings (char*) --> [length: 1 byte] [bytes...], up to 255 bytes.
+ */
+class binlog_t {
+private:
+    static uart_base_t* _uart;
+    static volatile uint32_t _dropped;
+
+public:
+    /**
+     * start logging to the UART. `begin_tx` must be called on it.
+     */
+    static void begin(uart_base_t& uart) { _uart = &uart; }
+
+    /* stop logging. */
+    static void end() { _uart = nullptr; }
+
+    /* get the count of records dropped because the TX queue was full. */
+    static uint32_t dropped() { return _dropped; }
+
+    /**
+     * serialize and enqueue a record. (use BINLOG_* macros instead)
+     * safe to call from any context, including interrupts.
+     */
+    template<typename ... Args>
+    static void emit(const char* fmt, Args ... args) {
+        if (!_uart) {
+            return;
+        }
+
+        uint8_t buf[6 + BINLOG_MAX_ARGS];
+        uint8_t* end = buf + sizeof(buf);
+        uint8_t* p = buf;
+
+        uint16_t id = uint16_t(fmt - __start_binlog_fmt) & 0x7fff;
+        *p++ = uint8_t(id);
+        *p++ = uint8_t(id >> 8);
+
+#if BINLOG_USE_TICK
+        put_raw(p, end, HAL_GetTick(), 4);
+#endif
+
+        pack(p, end, args...);
+
+        // --> cut: the rest of arguments were skipped.
+        if (!end) {
+            buf[1] |= 0x80;
+        }
+
+        send(buf, uint32_t(p - buf));
+    }
+
+private:
+    /* frame the record, and enqueue it under PRIMASK, since the TX queue has single producer. */
+    static void send(const uint8_t* buf, uint32_t len);
+
+    // --> an argument that does not fit sets `end` to null, and the rest are skipped.
+    //   : `p` stays at the end of the last whole argument.
+    static inline void put_raw(uint8_t*& p, uint8_t*& end, uint64_t v, uint8_t n) {
+        if (!end || n > end - p) {
+            end = nullptr;
+            return;
+        }
+
+        for (uint8_t i = 0; i < n; ++i) {
+            *p++ = uint8_t(v >> (i * 8));
+        }
+    }
+
+    static inline void pack(uint8_t*&, uint8_t*&) { }
+
+    template<typename T, typename ... Rest>
+    static inline void pack(uint8_t*& p, uint8_t*& end, T v, Rest ... rest) {
+        put(p, end, v);
+        pack(p, end, rest...);
+    }
+
+private:
+    static inline void put(uint8_t*& p, uint8_t*& end, int32_t v) { put_raw(p, end, uint32_t(v), 4); }
+    static inline void put(uint8_t*& p, uint8_t*& end, uint32_t v) { put_raw(p, end, v, 4); }
+    static inline void put(uint8_t*& p, uint8_t*& end, int64_t v) { put_raw(p, end, uint64_t(v), 8); }
+    static inline void put(uint8_t*& p, uint8_t*& end, uint64_t v) { put_raw(p, end, v, 8); }
+
+    static inline void put(uint8_t*& p, uint8_t*& end, char v) { put(p, end, int32_t(v)); }
+    static inline void put(uint8_t*& p, uint8_t*& end, signed char v) { put(p, end, int32_t(v)); }
+    static inline void put(uint8_t*& p, uint8_t*& end, unsigned char v) { put(p, end, uint32_t(v)); }
+    static inline void put(uint8_t*& p, uint8_t*& end, short v) { put(p, end, int32_t(v)); }
+    static inline void put(uint8_t*& p, uint8_t*& end, unsigned short v) { put(p, end, uint32_t(v)); }
+    static inline void put(uint8_t*& p, uint8_t*& end, bool v) { put(p, end, uint32_t(v)); }
+
+    // --> `long` is 32 bits on Cortex-M, and `int32_t` is `long` on some toolchains.
+    template<typename T>
+    static inline void put(uint8_t*& p, uint8_t*& end, T v) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "unsupported argument type.");
+        put_raw(p, end, uint64_t(v), sizeof(T));
+    }
+
+    static inline void put(uint8_t*& p, uint8_t*& end, float v) {
+        uint32_t u;
+        memcpy(&u, &v, 4);
+        put_raw(p, end, u, 4);
+    }
+
+    static inline void put(uint8_t*& p, uint8_t*& end, double v) { put(p, end, float(v)); }
+
+    static inline void put(uint8_t*& p, uint8_t*& end, const void* v) { put_raw(p, end, uint32_t(uintptr_t(v)), 4); }
+
+    static inline void put(uint8_t*& p, uint8_t*& end, const char* v) {
+        uint32_t n = v ? strlen(v) : 0;
+        if (n > 255) {
+            n = 255;
+        }
+
+        if (!end || 1 + n > uint32_t(end - p)) {
+            end = nullptr;
+            return;
+        }
+
+        *p++ = uint8_t(n);
+        memcpy(p, v, n);
+        p += n;
+    }
+
+    static inline void put(uint8_t*& p, uint8_t*& end, char* v) { put(p, end, (const char*) v); }
+};
+
+#endif // __BINLOG_H__
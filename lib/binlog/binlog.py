@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+binlog decoder: formats the records emitted by `binlog_t` on the host.
+
+usage:
+    python3 binlog.py firmware.elf < capture.bin
+    python3 binlog.py firmware.elf --port /dev/ttyUSB0 --baud 921600   (requires pyserial)
+    python3 binlog.py firmware.elf --no-tick                           (BINLOG_USE_TICK = 0)
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SECTION = "binlog_fmt"
+
+# --> %[flags][width][.precision][length]conversion
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfgGcsp%])")
+
+
+def read_formats(path):
+    """read the format section from the ELF, and returns { id: format string }."""
+    with open(path, "rb") as f:
+        elf = f.read()
+
+    if elf[:4] != b"\x7fELF":
+        raise ValueError("not an ELF file: " + path)
+
+    is64 = elf[4] == 2
+    end = "<" if elf[5] == 1 else ">"
+
+    if is64:
+        shoff, = struct.unpack_from(end + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x3a)
+        shdr = end + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(end + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x2e)
+        shdr = end + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(shdr, elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+
+    for sh in sections:
+        start = names[4] + sh[0]
+        name = elf[start:elf.index(b"\0", start)].decode()
+
+        if name == SECTION:
+            data = elf[sh[4]:sh[4] + sh[5]]
+            break
+    else:
+        raise ValueError("no '%s' section in %s" % (SECTION, path))
+
+    # --> each string is NUL terminated, and its offset is the ID.
+    formats = {}
+    pos = 0
+    while pos < len(data):
+        stop = data.index(b"\0", pos)
+        if stop > pos:
+            formats[pos] = data[pos:stop].decode(errors="replace")
+        pos = stop + 1
+
+    return formats
+
+
+def cobs_decode(buf):
+    out = bytearray()
+    i = 0
+
+    while i < len(buf):
+        code = buf[i]
+        if code == 0 or i + code > len(buf):
+            return None
+
+        out += buf[i + 1:i + code]
+        i += code
+
+        if code != 0xff and i < len(buf):
+            out.append(0)
+
+    return bytes(out)
+
+
+def format_record(fmt, args, cut=False):
+    """format the arguments using printf-style `fmt`, following the encoding of `binlog_t`.
+    the arguments run out at <cut>, if the record was cut by BINLOG_MAX_ARGS."""
+    out = []
+    last = 0
+    pos = 0
+
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+
+        spec = "%" + flags + width + ("." + prec if prec is not None else "")
+
+        if conv == "s":
+            if pos >= len(args) or pos + 1 + args[pos] > len(args):
+                out.append("<cut>")
+                pos = len(args)
+                continue
+
+            n = args[pos]
+            value = args[pos + 1:pos + 1 + n].decode(errors="replace")
+            pos += 1 + n
+            out.append((spec + "s") % value)
+            continue
+
+        size = 8 if length in ("ll", "j") else 4
+        if pos + size > len(args):
+            out.append("<cut>")
+            pos = len(args)
+            continue
+
+        raw = args[pos:pos + size]
+        pos += size
+
+        if conv in "di":
+            value, = struct.unpack("<q" if size == 8 else "<i", raw)
+            out.append((spec + "d") % value)
+        elif conv in "ouxX":
+            value, = struct.unpack("<Q" if size == 8 else "<I", raw)
+            out.append((spec + ("d" if conv == "u" else conv)) % value)
+        elif conv == "c":
+            out.append((spec + "c") % chr(raw[0]))
+        elif conv == "p":
+            out.append("0x%08x" % struct.unpack("<I", raw)[0])
+        else:
+            out.append((spec + conv) % struct.unpack("<f", raw)[0])
+
+    out.append(fmt[last:])
+
+    # --> cut, but every conversion was filled: the extra arguments were cut.
+    if cut and "<cut>" not in out:
+        out.append(" <cut>")
+
+    return "".join(out)
+
+
+def decode(formats, frame, tick):
+    rec = cobs_decode(frame)
+    head = 6 if tick else 2
+
+    if rec is None or len(rec) < head:
+        return "<malformed frame>"
+
+    # --> bit 15: the arguments were cut by BINLOG_MAX_ARGS.
+    fid, = struct.unpack_from("<H", rec, 0)
+    cut = bool(fid & 0x8000)
+    fid &= 0x7fff
+
+    if fid not in formats:
+        return "<unknown id %d>" % fid
+
+    level, where, fmt = formats[fid].split("|", 2)
+    text = format_record(fmt, rec[head:], cut)
+
+    if tick:
+        return "%10u %s %s: %s" % (struct.unpack_from("<I", rec, 2)[0], level, where, text)
+
+    return "%s %s: %s" % (level, where, text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="binlog decoder")
+    parser.add_argument("elf", help="firmware ELF with the '%s' section" % SECTION)
+    parser.add_argument("--port", help="serial port to read (requires pyserial), or stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--no-tick", action="store_true", help="records without tick (BINLOG_USE_TICK = 0)")
+    opts = parser.parse_args()
+
+    formats = read_formats(opts.elf)
+
+    if opts.port:
+        import serial
+        stream = serial.Serial(opts.port, opts.baud)
+    else:
+        stream = sys.stdin.buffer
+
+    pending = bytearray()
+    while True:
+        chunk = stream.read(1) if opts.port else stream.read1(4096)
+        if not chunk:
+            break
+
+        pending += chunk
+        while b"\0" in pending:
+            stop = pending.index(b"\0")
+            frame = bytes(pending[:stop])
+            del pending[:stop + 1]
+
+            if frame:
+                print(decode(formats, frame, not opts.no_tick), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,108 @@
+/**
+ * binlog host check: records are cut at the last whole argument, and flagged.
+ * this emits records through the UART TX queue, checks the frames, and writes them to stdout for `binlog.py`.
+ * host only: excluded from ARM builds, so the folder can be copied into the firmware as is.
+ * --
+ * build: (with the host `main.h`, see `../host`)
+ *  g++ -std=c++11 -DUART_USE_RING=1 -I../host binlog_check.cpp binlog.cpp ../uart/uart.cpp ../frame/frame.cpp ../host/hal.cpp -o binlog_check
+ *  ./binlog_check | python3 binlog.py binlog_check
+ */
+#if !defined(__arm__)
+
+#include "binlog.h"
+
+#include <stdio.h>
+#include <string>
+
+static UART_HandleTypeDef g_huart;
+static USART_TypeDef g_usart;
+
+static std::string g_wire;      // --> bytes sent by the TX DMA.
+static bool g_busy = false;
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef*, uint8_t* buf, uint16_t len) {
+    if (g_busy) {
+        return HAL_BUSY;
+    }
+
+    g_wire.append((const char*) buf, len);
+    g_busy = true;
+    return HAL_OK;
+}
+
+/* complete the TX DMA until the queue is empty, as the interrupt would. */
+static void drain() {
+    while (g_busy) {
+        g_busy = false;
+        HAL_UART_TxCpltCallback(&g_huart);
+    }
+}
+
+static int g_failed = 0;
+
+/* take the next frame from the wire, and check its length and the cut flag. */
+static void expect(const char* name, uint32_t len, bool cut) {
+    size_t stop = g_wire.find('\0');
+    if (stop == std::string::npos) {
+        fprintf(stderr, "FAILED %s: no frame\n", name);
+        g_failed++;
+        return;
+    }
+
+    std::string frame = g_wire.substr(0, stop);
+    uint32_t n = frame_t::decode_cobs((uint8_t*) &frame[0], uint32_t(frame.size()));
+
+    fwrite(g_wire.data(), 1, stop + 1, stdout);
+    g_wire.erase(0, stop + 1);
+
+    bool flag = n != 0xffffffffu && n >= 2 && (uint8_t(frame[1]) & 0x80);
+    bool ok = n == len && flag == cut;
+
+    fprintf(stderr, "%s %s: %u bytes (expected %u), cut %d\n", ok ? "ok    " : "FAILED", name, n, len, flag);
+    g_failed += ok ? 0 : 1;
+}
+
+int main() {
+    static ring_buf_t<1024> tx;
+    uart_base_t uart(&g_huart);
+
+    g_huart.Instance = &g_usart;
+    uart.enable();
+    uart.begin_tx(tx);
+    binlog_t::begin(uart);
+
+    const char* name = "bme280";
+    std::string longer(60, 'x');
+    const uint32_t head = BINLOG_USE_TICK ? 6 : 2;
+
+    static_assert(BINLOG_MAX_ARGS >= 8 && BINLOG_MAX_ARGS < 52, "the cases below assume BINLOG_MAX_ARGS 8 ~ 51.");
+
+    BINLOG_INFO("adc=%d volt=%.2f", 1234, 3.3);
+    drain();
+    expect("fits", head + 8, false);
+
+    BINLOG_ERROR("sensor %s timeout", name);
+    drain();
+    expect("string", head + 1 + 6, false);
+
+    // --> 13 integers: 52 bytes, the last ones are cut.
+    BINLOG_WARN("%d %d %d %d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13);
+    drain();
+    expect("too many args", head + BINLOG_MAX_ARGS / 4 * 4, true);
+
+    // --> the string does not fit: the integer after it is skipped, even if it fits.
+    BINLOG_WARN("%d %s %d", 1, longer.c_str(), 2);
+    drain();
+    expect("long string", head + 4, true);
+
+    fflush(stdout);
+
+    if (g_failed) {
+        fprintf(stderr, "FAILED: %d\n", g_failed);
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "dmabuf.h"
+
+dma_buf_t& dma_buf_t::operator =(dma_buf_t&& other) {
+    if (this != &other) {
+        release();
+
+        _pool = other._pool;
+        _data = other._data;
+        _size = other._size;
+        _len = other._len;
+
+        other._pool = nullptr;
+        other._data = nullptr;
+        other._size = other._len = 0;
+    }
+
+    return *this;
+}
+
+void dma_buf_t::release() {
+    if (_pool && _data) {
+        _pool->free(_data);
+    }
+
+    _pool = nullptr;
+    _data = nullptr;
+    _size = _len = 0;
+}
+
+// --
+dma_pool_ctl_t::dma_pool_ctl_t(uint8_t* data, uint32_t* used, uint16_t count, uint32_t block)
+    : _data(data), _used(used), _count(count), _block(block)
+{
+    for (uint32_t i = 0; i < (count + 31u) / 32u; ++i) {
+        _used[i] = 0;
+    }
+}
+
+uint16_t dma_pool_ctl_t::available() const {
+    uint16_t n = 0;
+
+    for (uint16_t i = 0; i < _count; ++i) {
+        if (!(_used[i / 32] & (1u << (i % 32)))) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+dma_buf_t dma_pool_ctl_t::alloc(uint32_t len) {
+    uint32_t words = (_count + 31u) / 32u;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (uint32_t i = 0; i < words; ++i) {
+        uint32_t free = ~_used[i];
+        if (!free) {
+            continue;
+        }
+
+        uint32_t n = i * 32 + __builtin_ctz(free);
+        if (n >= _count) {
+            break;
+        }
+
+        _used[i] |= 1u << (n % 32);
+        __set_PRIMASK(primask);
+
+        dma_buf_t buf(this, _data + n * _block, _block);
+        buf.length(len);
+        return buf;
+    }
+
+    __set_PRIMASK(primask);
+    return dma_buf_t();
+}
+
+void dma_pool_ctl_t::free(uint8_t* data) {
+    uint32_t n = uint32_t(data - _data) / _block;
+    if (data < _data || n >= _count) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    _used[n / 32] &= ~(1u << (n % 32));
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,198 @@
+#ifndef __DMABUF_H__
+#define __DMABUF_H__
+
+// --> STM32CubeMX generated header.
+#include "main.h"
+
+// --> D-Cache line size, in bytes.
+#ifndef DMABUF_ALIGN
+#define DMABUF_ALIGN    32
+#endif
+
+// --> 1 if the core has D-Cache. (Cortex-M7)
+#if defined(__DCACHE_PRESENT) && __DCACHE_PRESENT
+#define DMABUF_USE_CACHE    1
+#else
+#define DMABUF_USE_CACHE    0
+#endif
+
+// --> forward decl.
+class dma_pool_ctl_t;
+
+/**
+ * Describes an owned DMA buffer, allocated from `dma_pool_t`.
+ * this is move-only, and returns the block to the pool when destroyed.
+ * the block is aligned to, and padded to the D-Cache line, so no line is shared with others.
+ */
+class dma_buf_t {
+    friend class dma_pool_ctl_t;
+
+private:
+    dma_pool_ctl_t* _pool;
+    uint8_t* _data;
+    uint32_t _size;
+    uint32_t _len;
+
+private:
+    dma_buf_t(dma_pool_ctl_t* pool, uint8_t* data, uint32_t size)
+        : _pool(pool), _data(data), _size(size), _len(0)
+    {
+    }
+
+public:
+    /* initialize an empty handle. */
+    dma_buf_t() : _pool(nullptr), _data(nullptr), _size(0), _len(0) { }
+
+    dma_buf_t(const dma_buf_t&) = delete;
+    dma_buf_t& operator =(const dma_buf_t&) = delete;
+
+    /* move the ownership. */
+    dma_buf_t(dma_buf_t&& other)
+        : _pool(other._pool), _data(other._data), _size(other._size), _len(other._len)
+    {
+        other._pool = nullptr;
+        other._data = nullptr;
+        other._size = other._len = 0;
+    }
+
+    /* move the ownership, and release the current block. */
+    dma_buf_t& operator =(dma_buf_t&& other);
+
+    /* release the block. */
+    ~dma_buf_t() { release(); }
+
+public:
+    /* for null check. */
+    inline operator bool() const { return _data != nullptr; }
+    inline bool operator !() const { return _data == nullptr; }
+
+    /* get the data pointer. */
+    inline uint8_t* data() { return _data; }
+    inline const uint8_t* data() const { return _data; }
+
+    /* get the capacity in bytes. */
+    inline uint32_t size() const { return _size; }
+
+    /* get the length of valid bytes. */
+    inline uint32_t length() const { return _len; }
+
+    /* set the length of valid bytes. (clamped to the capacity) */
+    inline void length(uint32_t len) { _len = len < _size ? len : _size; }
+
+    /* return the block to the pool. */
+    void release();
+
+public:
+    /**
+     * write back the lines of [0, len) before DMA reads them. (memory to peripheral)
+     * `len` defaults to `length()`.
+     */
+    inline void clean(uint32_t len = 0xffffffffu) const {
+#if DMABUF_USE_CACHE
+        len = bound(len);
+        if (len) {
+            SCB_CleanDCache_by_Addr((uint32_t*) _data, lines(len));
+        }
+#else
+        (void) len;
+#endif
+    }
+
+    /**
+     * discard the lines of [0, len) before the CPU reads what DMA wrote. (peripheral to memory)
+     * call this before starting, and after completion of the DMA.
+     * `len` defaults to `length()`.
+     */
+    inline void invalidate(uint32_t len = 0xffffffffu) const {
+#if DMABUF_USE_CACHE
+        len = bound(len);
+        if (len) {
+            SCB_InvalidateDCache_by_Addr((void*) _data, lines(len));
+        }
+#else
+        (void) len;
+#endif
+    }
+
+private:
+    /* clamp the length. */
+    inline uint32_t bound(uint32_t len) const {
+        if (len == 0xffffffffu) {
+            len = _len;
+        }
+
+        return len < _size ? len : _size;
+    }
+
+    /* round up the length to the lines. */
+    static inline int32_t lines(uint32_t len) {
+        return int32_t((len + DMABUF_ALIGN - 1) & ~uint32_t(DMABUF_ALIGN - 1));
+    }
+};
+
+/**
+ * Describes a fixed-block pool controller of DMA buffers.
+ * allocation and release are O(count / 32), and safe to call from interrupt.
+ * the storage is provided by `dma_pool_t<blocks, bsize>`.
+ */
+class dma_pool_ctl_t {
+    friend class dma_buf_t;
+
+private:
+    uint8_t* _data;
+    uint32_t* _used;    // --> bitmap of allocated blocks.
+    uint16_t _count;
+    uint32_t _block;    // --> block size in bytes.
+
+public:
+    /**
+     * initialize a new pool on the storage.
+     * `data` must be aligned to DMABUF_ALIGN, and `block` must be a multiple of it.
+     */
+    dma_pool_ctl_t(uint8_t* data, uint32_t* used, uint16_t count, uint32_t block);
+
+public:
+    /* block size in bytes. */
+    inline uint32_t block() const { return _block; }
+
+    /* block count. */
+    inline uint16_t count() const { return _count; }
+
+    /* count of available blocks. */
+    uint16_t available() const;
+
+    /**
+     * allocate a block, or returns an empty handle if exhausted.
+     * `len` sets the initial length of valid bytes.
+     */
+    dma_buf_t alloc(uint32_t len = 0);
+
+private:
+    /* return the block to the pool. */
+    void free(uint8_t* data);
+};
+
+/**
+ * Describes a fixed-block pool of DMA buffers.
+ * each block is rounded up to DMABUF_ALIGN bytes.
+ * e.g. dma_pool_t<8, 256> --> 8 blocks of 256 bytes.
+ * --
+ * on STM32H7, place this in a DMA-accessible RAM (not DTCM), e.g. using a section attribute.
+ */
+template<uint16_t blocks, uint32_t bsize>
+class dma_pool_t : public dma_pool_ctl_t {
+private:
+    static constexpr uint32_t block_size = (bsize + DMABUF_ALIGN - 1) & ~uint32_t(DMABUF_ALIGN - 1);
+
+    static_assert(blocks > 0, "blocks must be greater than 0.");
+    static_assert(bsize > 0, "bsize must be greater than 0.");
+
+private:
+    alignas(DMABUF_ALIGN) uint8_t _storage[blocks * block_size];
+    uint32_t _bitmap[(blocks + 31) / 32];
+
+public:
+    dma_pool_t() : dma_pool_ctl_t(_storage, _bitmap, blocks, block_size) { }
+};
+
+#endif // __DMABUF_H__
@@ -0,0 +1,198 @@
+#ifndef __FLASH_PTR_H__
+#define __FLASH_PTR_H__
+
+#include <stdint.h>
+
+/**
+ * Describes a lazy view of an object stored on W25QXX flash.
+ * the object is fetched on first dereference, and kept until `reset`.
+ * if the fetch fails, dereferencing gives the last good object (or zero-initialized), check `valid`.
+ * --
+ * `D` can be `w25qxx_t` (STM32) or `W25QXX` (RP2040).
+ * `T` must be trivially copyable.
+ */
+template<typename T, typename D>
+class flash_ptr {
+private:
+    D* _dev;
+    uint32_t _addr;
+    uint8_t _valid;
+    T _cache;
+
+public:
+    /* initialize a new null view. */
+    flash_ptr() : _dev(nullptr), _addr(0), _valid(0), _cache() { }
+
+    /* initialize a new view on the address. */
+    flash_ptr(D& dev, uint32_t addr) : _dev(&dev), _addr(addr), _valid(0), _cache() { }
+
+public:
+    /* for null check. */
+    inline operator bool() const { return _dev != nullptr; }
+    inline bool operator !() const { return _dev == nullptr; }
+
+    /* get the flash address. */
+    inline uint32_t addr() const { return _addr; }
+
+    /* drop the cached object. the next access will fetch it again. */
+    inline void reset() { _valid = 0; }
+
+    /* test whether the cached object was fetched successfully since `reset`. */
+    inline bool valid() const { return _valid != 0; }
+
+    /**
+     * fetch the object, returns false if read failed.
+     */
+    bool fetch() {
+        if (_valid) {
+            return true;
+        }
+
+        // --> read aside: a partial read must not break the last good one.
+        T temp;
+        if (!_dev || _dev->read(_addr, (uint8_t*) &temp, sizeof(T)) != sizeof(T)) {
+            return false;
+        }
+
+        _cache = temp;
+        _valid = 1;
+        return true;
+    }
+
+    /* dereference. the last good object if `fetch` failed, see `valid`. */
+    inline const T& operator *() { fetch(); return _cache; }
+    inline const T* operator ->() { fetch(); return &_cache; }
+};
+
+/**
+ * Describes a lazy view of an array stored on W25QXX flash.
+ * indexing fetches a window of `window` elements around the index,
+ * so neighbouring accesses are served from the window.
+ * --
+ * RAM: sizeof(T) * window bytes.
+ */
+template<typename T, typename D, uint16_t window = 8>
+class flash_array {
+public:
+    static constexpr uint32_t NONE = 0xffffffffu;
+
+    /* prefetch direction. */
+    enum prefetch_t : uint8_t {
+        PREFETCH_FORWARD = 0,   // --> window starts at the index. (sequential scan)
+        PREFETCH_AROUND,        // --> index at the middle of window. (random lookup)
+        PREFETCH_BACKWARD,      // --> window ends at the index. (reverse scan)
+    };
+
+    static_assert(window > 0, "window must be greater than 0.");
+
+private:
+    D* _dev;
+    uint32_t _addr;
+    uint32_t _count;
+    uint32_t _first;    // --> first index in the window, or NONE.
+    uint16_t _loaded;   // --> loaded elements in the window.
+    prefetch_t _mode;
+    T _cache[window];
+
+public:
+    /* initialize a new null view. */
+    flash_array()
+        : _dev(nullptr), _addr(0), _count(0), _first(NONE), _loaded(0), _mode(PREFETCH_FORWARD) { }
+
+    /* initialize a new view on the address with element count. */
+    flash_array(D& dev, uint32_t addr, uint32_t count, prefetch_t mode = PREFETCH_FORWARD)
+        : _dev(&dev), _addr(addr), _count(count), _first(NONE), _loaded(0), _mode(mode) { }
+
+public:
+    /* for null check. */
+    inline operator bool() const { return _dev != nullptr; }
+    inline bool operator !() const { return _dev == nullptr; }
+
+    /* get the flash address. */
+    inline uint32_t addr() const { return _addr; }
+
+    /* get the element count. */
+    inline uint32_t size() const { return _count; }
+
+    /* set the prefetch direction. */
+    inline void prefetch(prefetch_t mode) { _mode = mode; }
+
+    /* drop the cached window. */
+    inline void reset() { _first = NONE; _loaded = 0; }
+
+    /* get a view of single element. */
+    inline flash_ptr<T, D> at(uint32_t index) const {
+        return flash_ptr<T, D>(*_dev, _addr + index * sizeof(T));
+    }
+
+    /**
+     * get an element pointer, fetching the window if needed.
+     * returns null if out of range, or read failed.
+     * the pointer is valid until next access.
+     */
+    const T* get(uint32_t index) {
+        if (index >= _count || !_dev) {
+            return nullptr;
+        }
+
+        if (_first == NONE || index < _first || index - _first >= _loaded) {
+            if (!load(index)) {
+                return nullptr;
+            }
+        }
+
+        return &_cache[index - _first];
+    }
+
+    /**
+     * read an element into `out`, returns false if failed.
+     */
+    inline bool read(uint32_t index, T& out) {
+        const T* ptr = get(index);
+        if (!ptr) {
+            return false;
+        }
+
+        out = *ptr;
+        return true;
+    }
+
+    /**
+     * read an element. returns default value if failed.
+     */
+    inline T operator [](uint32_t index) {
+        const T* ptr = get(index);
+        return ptr ? *ptr : T();
+    }
+
+private:
+    /* load the window for the index. */
+    bool load(uint32_t index) {
+        uint32_t first = index;
+
+        if (_mode == PREFETCH_AROUND) {
+            first = index > window / 2 ? index - window / 2 : 0;
+        }
+
+        else if (_mode == PREFETCH_BACKWARD) {
+            first = index >= window - 1u ? index - (window - 1u) : 0;
+        }
+
+        uint32_t n = _count - first;
+        if (n > window) {
+            n = window;
+        }
+
+        uint32_t len = n * sizeof(T);
+        if (_dev->read(_addr + first * sizeof(T), (uint8_t*) _cache, len) != len) {
+            reset();
+            return false;
+        }
+
+        _first = first;
+        _loaded = uint16_t(n);
+        return true;
+    }
+};
+
+#endif // __FLASH_PTR_H__
@@ -0,0 +1,185 @@
+#include "frame.h"
+
+uint32_t frame_t::decode_cobs(uint8_t* buf, uint32_t len) {
+    uint32_t i = 0, o = 0;
+
+    while (i < len) {
+        uint8_t code = buf[i++];
+        uint32_t run = code - 1;
+
+        if (!code || run > len - i) {
+            return 0xffffffffu;
+        }
+
+        // --> output never passes input, so this is safe in place.
+        memmove(buf + o, buf + i, run);
+        o += run; i += run;
+
+        if (code != 0xff && i < len) {
+            buf[o++] = 0;
+        }
+    }
+
+    return o;
+}
+
+uint32_t frame_t::decode_slip(uint8_t* buf, uint32_t len) {
+    uint32_t o = 0;
+
+    for (uint32_t i = 0; i < len; ++i) {
+        uint8_t ch = buf[i];
+
+        if (ch == 0xdb) {
+            if (++i >= len) {
+                return 0xffffffffu;
+            }
+
+            switch (buf[i]) {
+                case 0xdc: ch = 0xc0; break;
+                case 0xdd: ch = 0xdb; break;
+                default:
+                    return 0xffffffffu;
+            }
+        }
+
+        buf[o++] = ch;
+    }
+
+    return o;
+}
+
+const uint8_t* frame_reader_t::next(uint32_t& len) {
+    if (_held) {
+        return nullptr;
+    }
+
+    while (true) {
+        uint32_t first;
+        _ring.front(first); // --> settle the ring.
+
+        uint32_t count = _ring.count();
+        if (count > _ring.size()) {
+            count = _ring.size(); // --> overrun after settle, dropped on the next access.
+        }
+
+        if (_mode == frame_t::LENGTH) {
+            uint8_t hdr[2];
+
+            if (_ring.peek(hdr, 2) < 2) {
+                return nullptr;
+            }
+
+            uint32_t n = hdr[0] | (uint32_t(hdr[1]) << 8);
+            if (n > _max || n + 2 > _ring.size()) {
+                // --> no way to re-sync: drop all.
+                drop(count);
+                continue;
+            }
+
+            if (count < n + 2) {
+                return nullptr;
+            }
+
+            _held = n + 2;
+            len = n;
+            return span(2, n);
+        }
+
+        uint8_t delim = _mode == frame_t::COBS ? 0x00 : 0xc0;
+        int32_t end = scan(delim, count);
+
+        if (end < 0) {
+            _scan = _ring.tail() + count;
+
+            // --> no delimiter in the frame limit: drop it.
+            if (count > _max || count >= _ring.size()) {
+                drop(count);
+            }
+
+            return nullptr;
+        }
+
+        if (!end) {
+            _ring.consume(1); // --> empty frame. (e.g. leading SLIP END)
+            _scan = _ring.tail();
+            continue;
+        }
+
+        if (uint32_t(end) > _max) {
+            drop(end + 1);
+            continue;
+        }
+
+        uint8_t* buf = span(0, end);
+        uint32_t n = _mode == frame_t::COBS
+            ? frame_t::decode_cobs(buf, end)
+            : frame_t::decode_slip(buf, end);
+
+        if (n == 0xffffffffu) {
+            drop(end + 1);
+            continue;
+        }
+
+        _held = end + 1;
+        len = n;
+        return buf;
+    }
+}
+
+void frame_reader_t::release() {
+    if (_held) {
+        _ring.consume(_held);
+        _scan = _ring.tail();
+        _held = 0;
+    }
+}
+
+int32_t frame_reader_t::scan(uint8_t delim, uint32_t count) {
+    uint8_t* base = _ring.data();
+    uint32_t mask = _ring.size() - 1;
+    uint32_t offset = 0;
+
+    // --> skip bytes already scanned. (the tail may have passed them by overrun)
+    //   : `_scan` follows tail on consume, so a stale one never comes back after 2^32 bytes.
+    uint32_t ahead = _scan - _ring.tail();
+    if (ahead <= count) {
+        offset = ahead;
+    }
+
+    // --> at most two contiguous spans.
+    while (offset < count) {
+        uint32_t pos = (_ring.tail() + offset) & mask;
+        uint32_t n = _ring.size() - pos;
+
+        if (n > count - offset) {
+            n = count - offset;
+        }
+
+        const uint8_t* hit = (const uint8_t*) memchr(base + pos, delim, n);
+        if (hit) {
+            return int32_t(offset + (hit - (base + pos)));
+        }
+
+        offset += n;
+    }
+
+    return -1;
+}
+
+uint8_t* frame_reader_t::span(uint32_t offset, uint32_t len) {
+    uint32_t pos = (_ring.tail() + offset) & (_ring.size() - 1);
+
+    if (pos + len <= _ring.size()) {
+        return _ring.data() + pos;
+    }
+
+    // --> wrapped: `len` is already limited by `_max`.
+    _ring.peek(_scratch, len, offset);
+    return _scratch;
+}
+
+void frame_reader_t::drop(uint32_t len) {
+    _ring.consume(len);
+    _scan = _ring.tail();
+    _errors++;
+}
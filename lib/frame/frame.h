@@ -0,0 +1,206 @@
+#ifndef __FRAME_H__
+#define __FRAME_H__
+
+// --> SPSC byte ring.
+#include "../ring/ring.h"
+
+/**
+ * Packet framing modes.
+ */
+class frame_t {
+public:
+    /* COBS: frames are delimited by 0x00, overhead: 1 byte per 254 bytes + 2. */
+    static constexpr uint8_t COBS = 0;
+
+    /* SLIP (RFC 1055): frames are delimited by 0xc0, 0xc0 and 0xdb are escaped. */
+    static constexpr uint8_t SLIP = 1;
+
+    /* length-prefixed: 16-bit little endian length, and then payload. */
+    static constexpr uint8_t LENGTH = 2;
+
+public:
+    /**
+     * get the maximum encoded length of `len` bytes.
+     */
+    static constexpr uint32_t bound(uint8_t mode, uint32_t len) {
+        return mode == COBS ? len + len / 254 + 2
+            : (mode == SLIP ? len * 2 + 2 : len + 2);
+    }
+
+    /**
+     * decode a COBS frame (without delimiter) in place, and returns decoded length.
+     * returns 0xffffffff if malformed.
+     */
+    static uint32_t decode_cobs(uint8_t* buf, uint32_t len);
+
+    /**
+     * decode a SLIP frame (without delimiter) in place, and returns decoded length.
+     * returns 0xffffffff if malformed.
+     */
+    static uint32_t decode_slip(uint8_t* buf, uint32_t len);
+
+    /**
+     * encode bytes, and write them to `out` which has `writable()` and `write(buf, len)`.
+     * e.g. uart_base_t with `begin_tx`. payload bytes are written straight from `buf`.
+     * returns false without writing anything, if `out` has no space for the whole frame.
+     */
+    template<typename T>
+    static bool encode(T& out, uint8_t mode, const void* buf, uint32_t len);
+
+private:
+    template<typename T>
+    static void encode_cobs(T& out, const uint8_t* src, uint32_t len);
+
+    template<typename T>
+    static void encode_slip(T& out, const uint8_t* src, uint32_t len);
+};
+
+/**
+ * Describes a frame reader on the RX ring. (e.g. the ring of `uart_base_t::begin_ring`)
+ * this scans the ring by spans, decodes a complete frame in place,
+ * and hands it out as a span into the ring storage, without per-byte callbacks.
+ * --
+ * a frame wrapped around the end of the storage is decoded in `scratch` instead.
+ * call this from the consumer context only.
+ */
+class frame_reader_t {
+private:
+    ring_t& _ring;
+    uint8_t _mode;
+    uint8_t* _scratch;
+    uint32_t _max;      // --> max encoded frame length.
+
+    uint32_t _scan;     // --> ring index scanned up to, without delimiter.
+    uint32_t _held;     // --> bytes to consume on `release()`.
+    uint32_t _errors;
+
+public:
+    /**
+     * initialize a new frame reader.
+     * `scratch` is used for frames wrapped around the end of the ring, and limits the frame length.
+     */
+    frame_reader_t(ring_t& ring, uint8_t mode, void* scratch, uint32_t len)
+        : _ring(ring), _mode(mode), _scratch((uint8_t*) scratch), _max(len),
+          _scan(ring.tail()), _held(0), _errors(0)
+    {
+    }
+
+public:
+    /**
+     * get the next complete frame, or null if nothing ready.
+     * the span is valid until `release()`, which must be called before the next one.
+     */
+    const uint8_t* next(uint32_t& len);
+
+    /* release the frame returned by `next`. */
+    void release();
+
+    /* get the count of malformed or oversized frames dropped. */
+    inline uint32_t errors() const { return _errors; }
+
+private:
+    /* find the delimiter after `_scan`, and returns its offset from tail, or -1. */
+    int32_t scan(uint8_t delim, uint32_t count);
+
+    /* get the frame span at tail, in place if contiguous, or copied into scratch. */
+    uint8_t* span(uint32_t offset, uint32_t len);
+
+    /* drop bytes as an error. */
+    void drop(uint32_t len);
+};
+
+// --
+template<typename T>
+bool frame_t::encode(T& out, uint8_t mode, const void* buf, uint32_t len) {
+    const uint8_t* src = (const uint8_t*) buf;
+
+    if (out.writable() < bound(mode, len)) {
+        return false;
+    }
+
+    switch (mode) {
+        case COBS:
+            encode_cobs(out, src, len);
+            return true;
+
+        case SLIP:
+            encode_slip(out, src, len);
+            return true;
+
+        case LENGTH:
+            if (len > 0xffffu) {
+                return false;
+            }
+            else {
+                uint8_t hdr[2] = { uint8_t(len & 0xff), uint8_t(len >> 8) };
+
+                out.write(hdr, 2);
+                out.write(src, len);
+            }
+            return true;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+template<typename T>
+void frame_t::encode_cobs(T& out, const uint8_t* src, uint32_t len) {
+    const uint8_t* end = src + len;
+
+    while (true) {
+        uint32_t n = uint32_t(end - src);
+        if (n > 254) {
+            n = 254;
+        }
+
+        const uint8_t* zero = (const uint8_t*) memchr(src, 0, n);
+        uint32_t run = zero ? uint32_t(zero - src) : n;
+        uint8_t code = uint8_t(run + 1);
+
+        out.write(&code, 1);
+        out.write(src, run);
+        src += run;
+
+        if (zero) {
+            src++; // --> the zero is implied by the code.
+            continue;
+        }
+
+        if (run < 254) {
+            break; // --> the last block.
+        }
+    }
+
+    uint8_t delim = 0;
+    out.write(&delim, 1);
+}
+
+template<typename T>
+void frame_t::encode_slip(T& out, const uint8_t* src, uint32_t len) {
+    static const uint8_t END = 0xc0;
+    static const uint8_t ESC_END[2] = { 0xdb, 0xdc };
+    static const uint8_t ESC_ESC[2] = { 0xdb, 0xdd };
+
+    // --> leading END flushes line noise on the receiver.
+    out.write(&END, 1);
+
+    uint32_t run = 0;
+    for (uint32_t i = 0; i < len; ++i) {
+        if (src[i] != 0xc0 && src[i] != 0xdb) {
+            run++;
+            continue;
+        }
+
+        out.write(src + i - run, run);
+        out.write(src[i] == 0xc0 ? ESC_END : ESC_ESC, 2);
+        run = 0;
+    }
+
+    out.write(src + len - run, run);
+    out.write(&END, 1);
+}
+
+#endif // __FRAME_H__
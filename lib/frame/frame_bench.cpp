@@ -0,0 +1,185 @@
+/**
+ * frame host benchmark: encode/decode throughput and overhead of COBS, SLIP and length-prefixed framing.
+ * frames go through a ring as on the UART, against a plain copy through the same ring.
+ * host only: excluded from ARM builds, so the folder can be copied into the firmware as is.
+ * --
+ * build:
+ *  g++ -O2 -std=c++11 frame_bench.cpp frame.cpp -o frame_bench
+ */
+#if !defined(__arm__)
+
+#include "frame.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+/**
+ * Encoder target on the ring. (as `uart_base_t` with `begin_tx`)
+ */
+class bench_out_t {
+private:
+    ring_t& _ring;
+
+public:
+    bench_out_t(ring_t& ring) : _ring(ring) { }
+
+    inline uint32_t writable() const { return _ring.space(); }
+    inline uint32_t write(const void* buf, uint32_t len) { return _ring.write(buf, len); }
+};
+
+static double now() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static ring_buf_t<65536> g_ring;
+static uint8_t g_scratch[frame_t::bound(frame_t::SLIP, 4096)];
+
+struct result_t {
+    double enc;         // --> MB/s of payload.
+    double dec;
+    double overhead;    // --> wire bytes per payload byte, - 1.
+    bool ok;
+};
+
+/* encode frames until the ring is full, and decode them all. repeat for about 0.3 seconds. */
+static result_t run(uint8_t mode, const std::vector<uint8_t>& payload) {
+    uint32_t len = uint32_t(payload.size());
+    bench_out_t out(g_ring);
+    frame_reader_t reader(g_ring, mode, g_scratch, sizeof(g_scratch));
+
+    result_t res = { 0, 0, 0, true };
+    double t_enc = 0, t_dec = 0;
+    uint64_t bytes = 0, wire = 0;
+
+    g_ring.clear();
+    double begin = now();
+
+    while (now() - begin < 0.3) {
+        double t0 = now();
+        uint32_t frames = 0;
+        uint32_t before = g_ring.count();
+
+        while (frame_t::encode(out, mode, payload.data(), len)) {
+            ++frames;
+        }
+
+        wire += g_ring.count() - before;
+
+        double t1 = now();
+        const uint8_t* buf;
+        uint32_t n;
+
+        for (uint32_t i = 0; i < frames; ++i) {
+            if (!(buf = reader.next(n)) || n != len || memcmp(buf, payload.data(), len)) {
+                res.ok = false;
+                return res;
+            }
+
+            reader.release();
+        }
+
+        double t2 = now();
+
+        t_enc += t1 - t0;
+        t_dec += t2 - t1;
+        bytes += uint64_t(frames) * len;
+    }
+
+    res.enc = bytes / t_enc / 1e6;
+    res.dec = bytes / t_dec / 1e6;
+    res.overhead = double(wire) / bytes - 1;
+    res.ok = reader.errors() == 0 && g_ring.empty();
+    return res;
+}
+
+/* baseline: raw bytes through the same ring. */
+static result_t copy(const std::vector<uint8_t>& payload) {
+    uint32_t len = uint32_t(payload.size());
+    std::vector<uint8_t> temp(len);
+
+    result_t res = { 0, 0, 0, true };
+    double t_enc = 0, t_dec = 0;
+    uint64_t bytes = 0;
+
+    g_ring.clear();
+    double begin = now();
+
+    while (now() - begin < 0.3) {
+        double t0 = now();
+        uint32_t frames = 0;
+
+        while (g_ring.space() >= len) {
+            g_ring.write(payload.data(), len);
+            ++frames;
+        }
+
+        double t1 = now();
+        for (uint32_t i = 0; i < frames; ++i) {
+            g_ring.read(temp.data(), len);
+        }
+
+        double t2 = now();
+
+        t_enc += t1 - t0;
+        t_dec += t2 - t1;
+        bytes += uint64_t(frames) * len;
+    }
+
+    res.enc = bytes / t_enc / 1e6;
+    res.dec = bytes / t_dec / 1e6;
+    return res;
+}
+
+int main() {
+    static const uint32_t sizes[] = { 16, 64, 256, 1024 };
+    static const char* modes[] = { "COBS", "SLIP", "LENGTH" };
+    bool ok = true;
+
+    srand(1);
+    printf("payload throughput in MB/s, overhead in wire bytes per payload.\n\n");
+    printf("%-6s %-8s %6s %9s %9s %9s\n", "mode", "data", "size", "encode", "decode", "overhead");
+
+    for (uint32_t size : sizes) {
+        std::vector<uint8_t> random(size), worst(size);
+
+        for (uint32_t i = 0; i < size; ++i) {
+            random[i] = uint8_t(rand());
+        }
+
+        result_t base = copy(random);
+        printf("%-6s %-8s %6u %9.1f %9.1f %8.1f%%\n", "copy", "random", size, base.enc, base.dec, 0.0);
+
+        for (uint8_t mode = frame_t::COBS; mode <= frame_t::LENGTH; ++mode) {
+            // --> worst case: every byte is a delimiter.
+            for (uint32_t i = 0; i < size; ++i) {
+                worst[i] = mode == frame_t::SLIP ? 0xc0 : 0x00;
+            }
+
+            const std::vector<uint8_t>* data[] = { &random, &worst };
+            const char* names[] = { "random", "worst" };
+
+            for (uint32_t k = 0; k < 2; ++k) {
+                result_t res = run(mode, *data[k]);
+
+                if (!res.ok) {
+                    printf("%-6s %-8s %6u FAILED\n", modes[mode], names[k], size);
+                    ok = false;
+                    continue;
+                }
+
+                printf("%-6s %-8s %6u %9.1f %9.1f %8.1f%%\n",
+                       modes[mode], names[k], size, res.enc, res.dec, res.overhead * 100);
+            }
+        }
+
+        printf("\n");
+    }
+
+    return ok ? 0 : 1;
+}
+
+#endif
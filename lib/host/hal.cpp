@@ -0,0 +1,40 @@
+/**
+ * weak HAL functions of the host `main.h`: they succeed without doing anything.
+ * host only: excluded from ARM builds, so the folder can be copied into the firmware as is.
+ */
+#if !defined(__arm__)
+
+#include "main.h"
+
+#include <chrono>
+
+#define HOST_WEAK   __attribute__((weak))
+
+HOST_WEAK uint32_t HAL_GetTick() {
+    using namespace std::chrono;
+    static const steady_clock::time_point begin = steady_clock::now();
+    return uint32_t(duration_cast<milliseconds>(steady_clock::now() - begin).count());
+}
+
+HOST_WEAK GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef*, uint16_t) { return GPIO_PIN_RESET; }
+HOST_WEAK void HAL_GPIO_WritePin(GPIO_TypeDef*, uint16_t, GPIO_PinState) { }
+
+HOST_WEAK HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef*, uint8_t*, uint16_t, uint32_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef*, uint8_t*, uint16_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef*, uint8_t*, uint16_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef*, uint8_t*, uint16_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef*, uint8_t*, uint16_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef*) { return HAL_OK; }
+
+HOST_WEAK HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef*) { return HAL_SPI_STATE_READY; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef*) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef*, uint8_t*, uint16_t, uint32_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef*, uint8_t*, uint16_t, uint32_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef*, uint8_t*, uint8_t*, uint16_t, uint32_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef*, uint8_t*, uint16_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef*, uint8_t*, uint16_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef*, uint8_t*, uint8_t*, uint16_t) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_DMAStop(SPI_HandleTypeDef*) { return HAL_OK; }
+HOST_WEAK HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef*) { return HAL_OK; }
+
+#endif
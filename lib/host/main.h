@@ -0,0 +1,180 @@
+#ifndef __HOST_MAIN_H__
+#define __HOST_MAIN_H__
+
+/**
+ * Host stand-in of the STM32CubeMX generated `main.h`, to build the drivers on the PC.
+ * only the HAL parts used by `lib/uart`, `lib/spi` and `lib/pin` are declared, as STM32F4 names them.
+ * the functions are defined in `hal.cpp` as weak: the host tool overrides what it drives.
+ * --
+ * there is no interrupt on the host: the tool calls HAL callbacks itself, from one thread.
+ */
+#if defined(__arm__)
+#error "lib/host is for host builds only: use the CubeMX generated main.h on the target."
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define __IO    volatile
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HAL_OK = 0,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+// --> milliseconds since the first call.
+uint32_t HAL_GetTick();
+
+// --> core: PRIMASK and sleep are no-op.
+static inline uint32_t __get_PRIMASK() { return 0; }
+static inline void __set_PRIMASK(uint32_t) { }
+static inline void __disable_irq() { }
+static inline void __enable_irq() { }
+static inline uint32_t __get_IPSR() { return 0; }
+static inline void __WFI() { }
+static inline void __DSB() { }
+static inline void __DMB() { }
+
+// --> GPIO.
+typedef struct {
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+
+// --> DMA: `NDTR` is the remaining count, set by the tool.
+typedef struct {
+    __IO uint32_t NDTR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+    uint32_t Mode;
+} DMA_InitTypeDef;
+
+typedef struct {
+    DMA_Stream_TypeDef* Instance;
+    DMA_InitTypeDef Init;
+} DMA_HandleTypeDef;
+
+#define DMA_NORMAL      0x00000000u
+#define DMA_CIRCULAR    0x00000100u
+
+#define __HAL_DMA_GET_COUNTER(h)    ((h)->Instance->NDTR)
+
+// --> UART.
+typedef struct {
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+} USART_TypeDef;
+
+typedef enum {
+    HAL_UART_STATE_RESET = 0x00,
+    HAL_UART_STATE_READY = 0x20,
+    HAL_UART_STATE_BUSY = 0x24,
+    HAL_UART_STATE_BUSY_TX = 0x21,
+    HAL_UART_STATE_BUSY_RX = 0x22
+} HAL_UART_StateTypeDef;
+
+#define HAL_UART_ERROR_NONE     0x00u
+#define HAL_UART_ERROR_ORE      0x08u
+
+typedef struct __UART_HandleTypeDef {
+    USART_TypeDef* Instance;
+    uint16_t RxXferSize;
+    DMA_HandleTypeDef* hdmatx;
+    DMA_HandleTypeDef* hdmarx;
+    __IO HAL_UART_StateTypeDef gState;
+    __IO HAL_UART_StateTypeDef RxState;
+    __IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, uint8_t* buf, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, uint8_t* buf, uint16_t len);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef* huart, uint8_t* buf, uint16_t len);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef* huart, uint8_t* buf, uint16_t len);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef* huart, uint8_t* buf, uint16_t len);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef* huart);
+
+// --> defined by `lib/uart`: the host tool calls them instead of the interrupt.
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef* huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef* huart, uint16_t size);
+
+// --> SPI: no `SPI_CR1_BR`, so `spi_t::configure` goes through `HAL_SPI_Init`.
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+} SPI_TypeDef;
+
+typedef struct {
+    uint32_t Mode;
+    uint32_t Direction;
+    uint32_t DataSize;
+    uint32_t CLKPolarity;
+    uint32_t CLKPhase;
+    uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+typedef enum {
+    HAL_SPI_STATE_RESET = 0x00,
+    HAL_SPI_STATE_READY = 0x01,
+    HAL_SPI_STATE_BUSY = 0x02
+} HAL_SPI_StateTypeDef;
+
+typedef struct __SPI_HandleTypeDef {
+    SPI_TypeDef* Instance;
+    SPI_InitTypeDef Init;
+    DMA_HandleTypeDef* hdmatx;
+    DMA_HandleTypeDef* hdmarx;
+    __IO uint32_t ErrorCode;
+} SPI_HandleTypeDef;
+
+#define SPI_MODE_MASTER             0x00000104u
+#define SPI_DIRECTION_2LINES        0x00000000u
+#define SPI_DATASIZE_8BIT           0x00000000u
+#define SPI_POLARITY_LOW            0x00000000u
+#define SPI_POLARITY_HIGH           0x00000002u
+#define SPI_PHASE_1EDGE             0x00000000u
+#define SPI_PHASE_2EDGE             0x00000001u
+
+#define SPI_BAUDRATEPRESCALER_2     0x00000000u
+#define SPI_BAUDRATEPRESCALER_4     0x00000008u
+#define SPI_BAUDRATEPRESCALER_8     0x00000010u
+#define SPI_BAUDRATEPRESCALER_16    0x00000018u
+#define SPI_BAUDRATEPRESCALER_32    0x00000020u
+#define SPI_BAUDRATEPRESCALER_64    0x00000028u
+#define SPI_BAUDRATEPRESCALER_128   0x00000030u
+#define SPI_BAUDRATEPRESCALER_256   0x00000038u
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef* hspi);
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* buf, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef* hspi, uint8_t* buf, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi, uint8_t* tx, uint8_t* rx, uint16_t len, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, uint8_t* buf, uint16_t len);
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef* hspi, uint8_t* buf, uint16_t len);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef* hspi, uint8_t* tx, uint8_t* rx, uint16_t len);
+HAL_StatusTypeDef HAL_SPI_DMAStop(SPI_HandleTypeDef* hspi);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef* hspi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __HOST_MAIN_H__
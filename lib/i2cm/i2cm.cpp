@@ -0,0 +1,104 @@
+#include "i2cm.h"
+
+void i2cm_intr::proxy_cplt(hi2c_t hi2c) {
+    auto hook = i2cm_hook_t::root();
+    while(hook) {
+        auto next = hook->link();
+        if (hook->hooked() == hi2c) {
+            hook->on_cplt();
+        }
+
+        hook = next;
+    }
+}
+
+void i2cm_intr::proxy_error(hi2c_t hi2c) {
+    auto hook = i2cm_hook_t::root();
+    while(hook) {
+        auto next = hook->link();
+        if (hook->hooked() == hi2c) {
+            hook->on_error();
+        }
+
+        hook = next;
+    }
+}
+
+void i2cm_intr::proxy_abort(hi2c_t hi2c) {
+    auto hook = i2cm_hook_t::root();
+    while(hook) {
+        auto next = hook->link();
+        if (hook->hooked() == hi2c) {
+            hook->on_abort();
+        }
+
+        hook = next;
+    }
+}
+
+#if I2CM_USE_CALLBACKS
+extern "C" {
+    void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+        i2cm_intr::proxy_cplt(hi2c);
+    }
+
+    void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+        i2cm_intr::proxy_cplt(hi2c);
+    }
+
+    void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+        i2cm_intr::proxy_cplt(hi2c);
+    }
+
+    void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+        i2cm_intr::proxy_cplt(hi2c);
+    }
+
+    void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+        i2cm_intr::proxy_error(hi2c);
+    }
+
+    void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c) {
+        i2cm_intr::proxy_abort(hi2c);
+    }
+}
+#endif
+
+// --
+i2cm_hook_t* i2cm_hook_t::_root = nullptr;
+
+bool i2cm_hook_t::enable() {
+    auto temp = _root;
+    while(temp) {
+        if (temp == this) {
+            return false;
+        }
+
+        temp = temp->_link;
+    }
+
+    _link = _root;
+    _root = this;
+    return true;
+}
+
+bool i2cm_hook_t::disable() {
+    if (_root == this) {
+        _root = _link;
+        _link = nullptr;
+        return true;
+    }
+
+    auto temp = _root;
+    while(temp) {
+        if (temp->_link == this) {
+            temp->_link = _link;
+            _link = nullptr;
+            return true;
+        }
+
+        temp = temp->_link;
+    }
+
+    return false;
+}
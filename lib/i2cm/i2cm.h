@@ -4,9 +4,99 @@
 // --> STM32CubeMX generated header.
 #include "main.h"
 
+// --> set 0 to define HAL_I2C_*Callback functions by yourself.
+//   : then, call `i2cm_intr::proxy_*` functions from them to use i2cm_hook_t.
+#ifndef I2CM_USE_CALLBACKS
+#define I2CM_USE_CALLBACKS  1
+#endif
+
 // --> shortcut.
 using hi2c_t = I2C_HandleTypeDef*;
 
+/**
+ * I2C interrupt dispatcher. (impl: i2cm.cpp)
+ * if I2CM_USE_CALLBACKS is 0, call these from your own HAL_I2C_*Callback functions.
+ */
+class i2cm_intr {
+public:
+    /* proxy master TX/RX and memory TX/RX complete interrupt call to hook instances. */
+    static void proxy_cplt(hi2c_t hi2c);
+
+    /* proxy ERROR interrupt call to hook instances. */
+    static void proxy_error(hi2c_t hi2c);
+
+    /* proxy ABORT complete interrupt call to hook instances. */
+    static void proxy_abort(hi2c_t hi2c);
+};
+
+/**
+ * Describes an I2C interrupt hook.
+ */
+class i2cm_hook_t {
+    friend class i2cm_intr;
+
+private:
+    hi2c_t _hook;
+
+protected:
+    static i2cm_hook_t* _root;
+    i2cm_hook_t* _link;
+
+public:
+    /**
+     * initialize a i2cm_hook_t using its handle.
+     */
+    i2cm_hook_t(hi2c_t i2c) : _hook(i2c), _link(nullptr) { }
+
+    /**
+     * de-initialize the i2cm_hook_t.
+     * this will unlink self from root.
+     */
+    virtual ~i2cm_hook_t() { disable(); }
+
+protected:
+    /* get the root instance. */
+    inline static i2cm_hook_t* root() { return _root; }
+
+    /* get the linked instance. */
+    inline i2cm_hook_t* link() const { return _link; }
+
+protected:
+    /**
+     * called when TX or RX `complete` interrupt occurred.
+     * do not do complex something in this method.
+     */
+    virtual void on_cplt() { }
+
+    /**
+     * called when `error` interrupt occurred. (NACK, arbitration lost, bus error...)
+     */
+    virtual void on_error() { }
+
+    /**
+     * called when `abort` completed. (`HAL_I2C_Master_Abort_IT`)
+     */
+    virtual void on_abort() { }
+
+public:
+    /**
+     * get the hooked handle.
+     */
+    inline hi2c_t hooked() const { return _hook; }
+
+    /**
+     * enable this instance.
+     * actually, link this instance to root.
+     */
+    virtual bool enable();
+
+    /**
+     * disable this instance.
+     * actually, unlink this instance from root.
+     */
+    virtual bool disable();
+};
+
 /**
  * Describes an I2C interface.
  */
@@ -21,15 +111,16 @@ public:
      * initialize a new I2C interface as null device.
      */
     i2cm_t()
-        : _i2c(nullptr), _addr(0)
+        : _i2c(nullptr), _addr(0), _dma(0)
     {   
     }
 
     /**
      * initialize a new I2C interface using its handle and address.
+     * `dma` is used by the transaction queue only. (see `i2cm_queue.h`)
      */
-    i2cm_t(hi2c_t i2c, uint8_t addr)
-        : _i2c(i2c), _addr(addr)
+    i2cm_t(hi2c_t i2c, uint8_t addr, bool dma = false)
+        : _i2c(i2c), _addr(addr), _dma(dma ? 1 : 0)
     {
     }
     
@@ -50,6 +141,11 @@ public:
      */
     inline uint8_t addr() const { return _addr; }
 
+    /**
+     * indicates whether the I2C instance uses DMA or not.
+     */
+    inline bool use_dma() const { return _dma != 0; }
+
     /**
      * write bytes through I2C interface.
      */
@@ -63,5 +159,34 @@ public:
     inline bool read(void* buf, uint32_t len, uint32_t timeout = 0xffffffffu) {
         return HAL_I2C_Master_Receive(_i2c, (_addr << 1) | 1, (uint8_t*) buf, len, timeout) == HAL_OK;
     }
+
+    /**
+     * read registers from `reg` in a transaction. (register address, repeated start, then read)
+     * the device increments the register address for burst reads.
+     */
+    inline bool read_reg(uint8_t reg, void* buf, uint32_t len, uint32_t timeout = 0xffffffffu) {
+        return HAL_I2C_Mem_Read(_i2c, _addr << 1, reg, I2C_MEMADD_SIZE_8BIT, (uint8_t*) buf, len, timeout) == HAL_OK;
+    }
+
+    /**
+     * write registers from `reg` in a transaction.
+     */
+    inline bool write_reg(uint8_t reg, const void* buf, uint32_t len, uint32_t timeout = 0xffffffffu) {
+        return HAL_I2C_Mem_Write(_i2c, _addr << 1, reg, I2C_MEMADD_SIZE_8BIT, (uint8_t*) buf, len, timeout) == HAL_OK;
+    }
+
+    /**
+     * read registers with 16-bit register address. (MSB first, e.g. EEPROMs)
+     */
+    inline bool read_reg16(uint16_t reg, void* buf, uint32_t len, uint32_t timeout = 0xffffffffu) {
+        return HAL_I2C_Mem_Read(_i2c, _addr << 1, reg, I2C_MEMADD_SIZE_16BIT, (uint8_t*) buf, len, timeout) == HAL_OK;
+    }
+
+    /**
+     * write registers with 16-bit register address.
+     */
+    inline bool write_reg16(uint16_t reg, const void* buf, uint32_t len, uint32_t timeout = 0xffffffffu) {
+        return HAL_I2C_Mem_Write(_i2c, _addr << 1, reg, I2C_MEMADD_SIZE_16BIT, (uint8_t*) buf, len, timeout) == HAL_OK;
+    }
 };
 #endif // __I2CM_H__
\ No newline at end of file
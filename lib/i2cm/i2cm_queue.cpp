@@ -0,0 +1,379 @@
+#include "i2cm_queue.h"
+
+/**
+ * Disables interrupts while the statement context is alive.
+ */
+class i2cm_queue_lock_t {
+private:
+    uint32_t _primask;
+
+public:
+    i2cm_queue_lock_t() : _primask(__get_PRIMASK()) { __disable_irq(); }
+    ~i2cm_queue_lock_t() { __set_PRIMASK(_primask); }
+};
+
+bool i2cm_queue_t::submit(i2cm_xfer_t* xfer) {
+    if (!xfer || !hooked()) {
+        return false;
+    }
+
+    i2cm_xfer_t* last = xfer;
+    while(true) {
+        if (!last->len || (!last->tx == !last->rx) ||
+            last->state == i2cm_xfer_t::PENDING || last->state == i2cm_xfer_t::ACTIVE)
+        {
+            return false;
+        }
+
+        // --> the memory transfer always ends with STOP.
+        uint8_t reg = last->flags & (i2cm_xfer_t::REG8 | i2cm_xfer_t::REG16);
+        if (reg == (i2cm_xfer_t::REG8 | i2cm_xfer_t::REG16) ||
+            (reg && (last->flags & i2cm_xfer_t::NOSTOP)))
+        {
+            return false;
+        }
+
+#ifndef I2C_OTHER_FRAME
+        // --> the HAL continues in the same direction without repeated start, and address.
+        if ((last->flags & i2cm_xfer_t::NOSTOP) && last->next && !last->rx == !last->next->rx) {
+            return false;
+        }
+#endif
+
+        if (!last->next) {
+            break;
+        }
+
+        last = last->next;
+    }
+
+    // --> NOSTOP on the last one would join the next submission.
+    last->flags &= ~i2cm_xfer_t::NOSTOP;
+
+    for (i2cm_xfer_t* temp = xfer; temp; temp = temp->next) {
+        temp->state = i2cm_xfer_t::PENDING;
+    }
+
+    i2cm_queue_lock_t _;
+    push(xfer, last);
+
+    if (!_cur && !_aborting) {
+        run(pick());
+    }
+
+    return true;
+}
+
+bool i2cm_queue_t::wait(const i2cm_xfer_t* xfer, uint32_t timeout) const {
+    uint32_t tick = HAL_GetTick();
+    while(!xfer->finished()) {
+        uint32_t now = HAL_GetTick();
+        if ((now - tick) >= timeout) {
+            return false;
+        }
+    }
+
+    return xfer->state == i2cm_xfer_t::DONE;
+}
+
+bool i2cm_queue_t::cancel(i2cm_xfer_t* xfer) {
+    i2cm_queue_lock_t _;
+
+    // --> running: abort it, and start the next frame when the bus is released.
+    for (i2cm_xfer_t* temp = xfer; temp; temp = temp->next) {
+        if (temp == _cur) {
+            halt();
+            return true;
+        }
+
+        if (!(temp->flags & i2cm_xfer_t::NOSTOP)) {
+            break;
+        }
+    }
+
+    // --> pending: unlink the frame.
+    i2cm_xfer_t* prev = nullptr;
+    for (i2cm_xfer_t* temp = _head; temp; prev = temp, temp = temp->next) {
+        if (temp != xfer) {
+            continue;
+        }
+
+        i2cm_xfer_t* last = xfer;
+        while ((last->flags & i2cm_xfer_t::NOSTOP) && last->next) {
+            last = last->next;
+        }
+
+        if (prev) {
+            prev->next = last->next;
+        }
+        else {
+            _head = last->next;
+        }
+
+        if (_tail == last) {
+            _tail = prev;
+        }
+
+        last->next = nullptr;
+        while (xfer) {
+            i2cm_xfer_t* next = xfer->next;
+
+            xfer->state = i2cm_xfer_t::ERROR;
+            if (xfer->done) {
+                xfer->done(xfer);
+            }
+
+            xfer = next;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void i2cm_queue_t::abort() {
+    i2cm_queue_lock_t _;
+
+    i2cm_xfer_t* temp = _head;
+    _head = _tail = nullptr;
+
+    if (_cur) {
+        halt();
+    }
+
+    while(temp) {
+        i2cm_xfer_t* next = temp->next;
+
+        temp->state = i2cm_xfer_t::ERROR;
+        if (temp->done) {
+            temp->done(temp);
+        }
+
+        temp = next;
+    }
+}
+
+void i2cm_queue_t::push(i2cm_xfer_t* first, i2cm_xfer_t* last) {
+    if (!_head) {
+        _head = first;
+    }
+    else {
+        _tail->next = first;
+    }
+
+    _tail = last;
+}
+
+i2cm_xfer_t* i2cm_queue_t::pick() {
+    i2cm_xfer_t* first = _head;
+    if (!first) {
+        return nullptr;
+    }
+
+    // --> take whole frame, and cut it from the pending list.
+    i2cm_xfer_t* last = first;
+    while ((last->flags & i2cm_xfer_t::NOSTOP) && last->next) {
+        last = last->next;
+    }
+
+    _head = last->next;
+    if (!_head) {
+        _tail = nullptr;
+    }
+
+    last->next = nullptr;
+    return first;
+}
+
+void i2cm_queue_t::on_cplt() {
+    if (!_cur) {
+        resume();
+        return;
+    }
+
+    uint8_t state = _canceled ? i2cm_xfer_t::ERROR : i2cm_xfer_t::DONE;
+
+    _canceled = false;
+    run(finish(_cur, state));
+}
+
+void i2cm_queue_t::on_error() {
+    if (!_cur) {
+        resume();
+        return;
+    }
+
+    _canceled = false;
+    run(finish(_cur, i2cm_xfer_t::ERROR));
+}
+
+void i2cm_queue_t::on_abort() {
+    resume();
+}
+
+void i2cm_queue_t::run(i2cm_xfer_t* xfer) {
+    while(xfer) {
+        _cur = xfer;
+        xfer->state = i2cm_xfer_t::ACTIVE;
+
+        if (start(xfer)) {
+            return;
+        }
+
+        xfer = finish(xfer, i2cm_xfer_t::ERROR);
+    }
+
+    _cur = nullptr;
+}
+
+i2cm_xfer_t* i2cm_queue_t::finish(i2cm_xfer_t* xfer, uint8_t state) {
+    i2cm_xfer_t* next = xfer->next;
+
+    if (complete(xfer, state)) {
+        return next; // --> continue the frame with repeated start.
+    }
+
+    return pick();
+}
+
+bool i2cm_queue_t::complete(i2cm_xfer_t* xfer, uint8_t state) {
+    i2cm_xfer_t* next = xfer->next;
+    bool hold = (xfer->flags & i2cm_xfer_t::NOSTOP) && next;
+
+    _held = hold && state != i2cm_xfer_t::ERROR;
+
+    xfer->state = state;
+    if (xfer->done) {
+        xfer->done(xfer);
+    }
+
+    if (state == i2cm_xfer_t::ERROR) {
+        // --> drop the rest of the frame.
+        while (hold) {
+            i2cm_xfer_t* temp = next;
+
+            next = temp->next;
+            hold = (temp->flags & i2cm_xfer_t::NOSTOP) && next;
+
+            temp->state = i2cm_xfer_t::ERROR;
+            if (temp->done) {
+                temp->done(temp);
+            }
+        }
+    }
+
+    return _held;
+}
+
+void i2cm_queue_t::halt() {
+    i2cm_xfer_t* xfer = _cur;
+
+    // --> the HAL refuses to abort a memory transfer, or the one finished already.
+    //   : it keeps using the buffer until its callback, so the descriptor stays active till then.
+    if (HAL_I2C_Master_Abort_IT(hooked(), uint16_t(xfer->addr << 1)) != HAL_OK) {
+        _canceled = true;
+        return;
+    }
+
+    // --> the HAL calls back (abort, or complete if it can not abort) when the bus is released.
+    //   : until then, new descriptors are kept pending.
+    _cur = nullptr;
+    _aborting = true;
+
+    complete(xfer, i2cm_xfer_t::ERROR);
+}
+
+void i2cm_queue_t::resume() {
+    if (!_aborting) {
+        return;
+    }
+
+    _aborting = false;
+    run(pick());
+}
+
+bool i2cm_queue_t::start(i2cm_xfer_t* xfer) {
+    hi2c_t i2c = hooked();
+    uint16_t addr = uint16_t(xfer->addr << 1);
+    uint8_t* tx = (uint8_t*) xfer->tx;
+    uint8_t* rx = (uint8_t*) xfer->rx;
+    HAL_StatusTypeDef ret;
+
+    // --> a part of NOSTOP frame: the sequential transfer. (IT only)
+    //   : OTHER frames always generate repeated start and address, NEXT and LAST do only if the direction changes.
+    if (_held || (xfer->flags & i2cm_xfer_t::NOSTOP)) {
+        uint32_t opts;
+        if (!_held) {
+            opts = I2C_FIRST_FRAME;
+        }
+        else if (xfer->flags & i2cm_xfer_t::NOSTOP) {
+#ifdef I2C_OTHER_FRAME
+            opts = I2C_OTHER_FRAME;
+#else
+            opts = I2C_NEXT_FRAME;
+#endif
+        }
+        else {
+#ifdef I2C_OTHER_AND_LAST_FRAME
+            opts = I2C_OTHER_AND_LAST_FRAME;
+#else
+            opts = I2C_LAST_FRAME;
+#endif
+        }
+
+        if (tx) {
+            ret = HAL_I2C_Master_Seq_Transmit_IT(i2c, addr, tx, xfer->len, opts);
+        }
+        else {
+            ret = HAL_I2C_Master_Seq_Receive_IT(i2c, addr, rx, xfer->len, opts);
+        }
+
+        return ret == HAL_OK;
+    }
+
+    // --> register access: address, repeated start, and data in a transaction.
+    if (xfer->flags & (i2cm_xfer_t::REG8 | i2cm_xfer_t::REG16)) {
+        uint16_t size = (xfer->flags & i2cm_xfer_t::REG16) ? I2C_MEMADD_SIZE_16BIT : I2C_MEMADD_SIZE_8BIT;
+
+        if (_dma) {
+            if (tx) {
+                ret = HAL_I2C_Mem_Write_DMA(i2c, addr, xfer->reg, size, tx, xfer->len);
+            }
+            else {
+                ret = HAL_I2C_Mem_Read_DMA(i2c, addr, xfer->reg, size, rx, xfer->len);
+            }
+        }
+
+        else {
+            if (tx) {
+                ret = HAL_I2C_Mem_Write_IT(i2c, addr, xfer->reg, size, tx, xfer->len);
+            }
+            else {
+                ret = HAL_I2C_Mem_Read_IT(i2c, addr, xfer->reg, size, rx, xfer->len);
+            }
+        }
+
+        return ret == HAL_OK;
+    }
+
+    if (_dma) {
+        if (tx) {
+            ret = HAL_I2C_Master_Transmit_DMA(i2c, addr, tx, xfer->len);
+        }
+        else {
+            ret = HAL_I2C_Master_Receive_DMA(i2c, addr, rx, xfer->len);
+        }
+    }
+
+    else {
+        if (tx) {
+            ret = HAL_I2C_Master_Transmit_IT(i2c, addr, tx, xfer->len);
+        }
+        else {
+            ret = HAL_I2C_Master_Receive_IT(i2c, addr, rx, xfer->len);
+        }
+    }
+
+    return ret == HAL_OK;
+}
@@ -0,0 +1,183 @@
+#ifndef __I2CM_QUEUE_H__
+#define __I2CM_QUEUE_H__
+
+// --> I2C wrapper.
+#include "i2cm.h"
+
+/**
+ * Describes an I2C transfer descriptor.
+ * the descriptor must be alive until it completes.
+ */
+struct i2cm_xfer_t {
+    /**
+     * flags.
+     * REG8, REG16: write `reg` first, then read or write with repeated start. (`HAL_I2C_Mem_*`)
+     * NOSTOP: do not generate STOP, and continue with `next` by repeated start and its address. (`HAL_I2C_Master_Seq_*`)
+     *   : without `I2C_OTHER_FRAME` (old HAL), the HAL skips the restart in the same direction,
+     *   : so `submit` accepts only NOSTOP chains which change the direction.
+     */
+    static constexpr uint8_t REG8 = 0x01;
+    static constexpr uint8_t REG16 = 0x02;
+    static constexpr uint8_t NOSTOP = 0x04;
+
+    /**
+     * states.
+     */
+    static constexpr uint8_t IDLE = 0;
+    static constexpr uint8_t PENDING = 1;
+    static constexpr uint8_t ACTIVE = 2;
+    static constexpr uint8_t DONE = 3;
+    static constexpr uint8_t ERROR = 4;
+
+    /* 7-bit device address. (same as `i2cm_t::addr`) */
+    uint8_t addr;
+
+    /* TX buffer, to write. */
+    const void* tx;
+
+    /* RX buffer, to read. exclusive with `tx`. */
+    void* rx;
+
+    /* length in bytes. */
+    uint16_t len;
+
+    /* register address, with REG8 or REG16. */
+    uint16_t reg;
+
+    /* REG8, REG16, NOSTOP or 0. */
+    uint8_t flags;
+
+    /* IDLE, PENDING, ACTIVE, DONE or ERROR. */
+    volatile uint8_t state;
+
+    /* called from interrupt when the transfer completed or failed. */
+    void (*done)(i2cm_xfer_t* xfer);
+
+    /* user data. */
+    void* user;
+
+    /**
+     * next descriptor in the chain.
+     * set this before `submit` to chain descriptors, and the queue uses it internally.
+     */
+    i2cm_xfer_t* next;
+
+    i2cm_xfer_t()
+        : addr(0), tx(nullptr), rx(nullptr), len(0), reg(0), flags(0), state(IDLE),
+          done(nullptr), user(nullptr), next(nullptr)
+    {
+    }
+
+    /* test whether the transfer completed (or failed) or not. */
+    inline bool finished() const { return state == DONE || state == ERROR; }
+};
+
+/**
+ * Describes an I2C transaction queue, shared by the devices on the bus.
+ * descriptors are started back to back from the HAL complete callbacks,
+ * and a failed one (e.g. NACK) does not affect the others, except the rest of its NOSTOP frame.
+ * --
+ * warning: do not use blocking calls of `i2cm_t` on the same handle while the queue is busy.
+ */
+class i2cm_queue_t : public i2cm_hook_t {
+private:
+    i2cm_xfer_t* _head;
+    i2cm_xfer_t* _tail;
+    i2cm_xfer_t* _cur;
+    bool _aborting;     // --> waiting the HAL to finish the aborted one.
+    bool _canceled;     // --> the active one could not be aborted: finish it with ERROR on its callback.
+    bool _held;         // --> the previous one ended without STOP.
+    bool _dma;
+
+public:
+    /**
+     * initialize a new queue on the handle.
+     * call `enable()` to receive callbacks.
+     */
+    i2cm_queue_t(hi2c_t i2c, bool dma = false)
+        : i2cm_hook_t(i2c), _head(nullptr), _tail(nullptr), _cur(nullptr),
+          _aborting(false), _canceled(false), _held(false), _dma(dma)
+    {
+    }
+
+    /**
+     * initialize a new queue on the handle of the interface, with its DMA setting.
+     */
+    i2cm_queue_t(const i2cm_t& i2c)
+        : i2cm_queue_t(i2c.i2c(), i2c.use_dma())
+    {
+    }
+
+public:
+    /* test whether the queue is working or not. */
+    inline bool busy() const { return _cur != nullptr || _aborting; }
+
+    /**
+     * submit a descriptor chain (linked by `next`), and start if idle.
+     * the chain is appended atomically, and runs back to back.
+     * NOSTOP-ed frames are never interleaved.
+     * this can be called from interrupt.
+     */
+    bool submit(i2cm_xfer_t* xfer);
+
+    /**
+     * wait for the descriptor to be finished.
+     * returns true if it completed successfully before timeout.
+     */
+    bool wait(const i2cm_xfer_t* xfer, uint32_t timeout = 0xffffffffu) const;
+
+    /**
+     * cancel the frame starting at `xfer`, pending or running.
+     * canceled descriptors are finished with ERROR.
+     * the HAL can not abort a register access (REG8, REG16): it runs to its end,
+     * and is finished with ERROR then. its buffer is in use until `finished()`.
+     */
+    bool cancel(i2cm_xfer_t* xfer);
+
+    /**
+     * abort all pending descriptors, and the active one.
+     * aborted descriptors are finished with ERROR. (the active one may be later, as `cancel`)
+     */
+    void abort();
+
+protected:
+    virtual void on_cplt() override;
+    virtual void on_error() override;
+    virtual void on_abort() override;
+
+    /**
+     * pick the next frame head to start, and unlink the frame from the pending list.
+     * the default implementation is FIFO.
+     */
+    virtual i2cm_xfer_t* pick();
+
+    /**
+     * append the chain to the pending list.
+     * called with interrupts disabled.
+     */
+    virtual void push(i2cm_xfer_t* first, i2cm_xfer_t* last);
+
+    /* get the pending list head. */
+    inline i2cm_xfer_t*& pending() { return _head; }
+
+private:
+    /* start descriptors until one is running. (or nothing left) */
+    void run(i2cm_xfer_t* xfer);
+
+    /* start the transfer on HAL, returns false if failed. */
+    bool start(i2cm_xfer_t* xfer);
+
+    /* finish the transfer, and returns the next descriptor in the frame, or the next frame. */
+    i2cm_xfer_t* finish(i2cm_xfer_t* xfer, uint8_t state);
+
+    /* finish the transfer (and the rest of the frame, if failed), returns true if the frame continues. */
+    bool complete(i2cm_xfer_t* xfer, uint8_t state);
+
+    /* abort the active one, and finish its frame with ERROR. (or on its callback, if the HAL refused) */
+    void halt();
+
+    /* continue after the aborted one is stopped by the HAL. */
+    void resume();
+};
+
+#endif // __I2CM_QUEUE_H__
@@ -0,0 +1,118 @@
+#include "i2cm_sweep.h"
+
+int32_t i2cm_sweep_t::add(uint8_t addr, void* buf, uint16_t len) {
+    return add_reg(addr, 0, buf, len, 0);
+}
+
+int32_t i2cm_sweep_t::add_reg(uint8_t addr, uint16_t reg, void* buf, uint16_t len, uint8_t flags) {
+    if (_count >= _max || busy() || !buf || !len) {
+        return -1;
+    }
+
+    i2cm_xfer_t& xfer = _xfers[_count];
+
+    xfer.addr = addr;
+    xfer.tx = nullptr;
+    xfer.rx = buf;
+    xfer.len = len;
+    xfer.reg = reg;
+    xfer.flags = flags & (i2cm_xfer_t::REG8 | i2cm_xfer_t::REG16);
+    xfer.state = i2cm_xfer_t::IDLE;
+    xfer.done = on_xfer;
+    xfer.user = this;
+
+    return _count++;
+}
+
+bool i2cm_sweep_t::clear() {
+    if (busy()) {
+        return false;
+    }
+
+    _count = 0;
+    return true;
+}
+
+bool i2cm_sweep_t::start() {
+    if (!_count) {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (_left) {
+        __set_PRIMASK(primask);
+        return false;
+    }
+
+    // --> the queue unlinks descriptors as it runs, so link them again.
+    for (uint8_t i = 0; i < _count; ++i) {
+        _xfers[i].next = i + 1 < _count ? &_xfers[i + 1] : nullptr;
+        _xfers[i].state = i2cm_xfer_t::IDLE;
+    }
+
+    _left = _count;
+    _failed = 0;
+
+    bool ret = _queue.submit(_xfers);
+    if (!ret) {
+        _left = 0;
+    }
+
+    __set_PRIMASK(primask);
+    return ret;
+}
+
+bool i2cm_sweep_t::wait(uint32_t timeout) const {
+    uint32_t tick = HAL_GetTick();
+
+    while(true) {
+#if I2CM_WAIT_SLEEP
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        // --> test under PRIMASK: the last completion after this wakes WFI, not lost.
+        if (!busy()) {
+            __set_PRIMASK(primask);
+            break;
+        }
+
+        // --> sleep only in thread mode with interrupts enabled.
+        if (!primask && !__get_IPSR()) {
+            __WFI();
+        }
+
+        __set_PRIMASK(primask);
+#else
+        if (!busy()) {
+            break;
+        }
+#endif
+
+        uint32_t now = HAL_GetTick();
+        if ((now - tick) >= timeout) {
+            return false;
+        }
+    }
+
+    return _failed == 0;
+}
+
+void i2cm_sweep_t::on_xfer(i2cm_xfer_t* xfer) {
+    i2cm_sweep_t* sweep = (i2cm_sweep_t*) xfer->user;
+
+    if (xfer->state != i2cm_xfer_t::DONE) {
+        sweep->_failed = sweep->_failed + 1;
+    }
+
+    sweep->_left = sweep->_left - 1;
+    if (sweep->_left) {
+        return;
+    }
+
+    sweep->_sweeps = sweep->_sweeps + 1;
+    if (sweep->_done) {
+        sweep->_done(sweep);
+    }
+}
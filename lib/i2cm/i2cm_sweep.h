@@ -0,0 +1,110 @@
+#ifndef __I2CM_SWEEP_H__
+#define __I2CM_SWEEP_H__
+
+// --> I2C transaction queue.
+#include "i2cm_queue.h"
+
+// --> set 0 to busy-wait instead of sleeping (WFI) in `i2cm_sweep_t::wait`.
+#ifndef I2CM_WAIT_SLEEP
+#define I2CM_WAIT_SLEEP     1
+#endif
+
+/**
+ * Describes a poll group: reads of several devices, run back to back as a chain on the queue.
+ * each entry reads into its own slot of the snapshot, and fails alone. (NACK, ...)
+ * the storage is provided by `i2cm_sweep_buf_t<entries>`.
+ */
+class i2cm_sweep_t {
+private:
+    i2cm_queue_t& _queue;
+    i2cm_xfer_t* _xfers;
+    uint8_t _max;
+    uint8_t _count;
+
+    volatile uint8_t _left;     // --> entries not finished in the running sweep.
+    volatile uint8_t _failed;   // --> entries failed in the last sweep.
+    volatile uint32_t _sweeps;  // --> sweeps finished.
+
+    void (*_done)(i2cm_sweep_t* sweep);
+
+public:
+    /* user data. */
+    void* user;
+
+public:
+    /**
+     * initialize a new poll group on the queue, and the descriptor storage.
+     */
+    i2cm_sweep_t(i2cm_queue_t& queue, i2cm_xfer_t* xfers, uint8_t max)
+        : _queue(queue), _xfers(xfers), _max(max), _count(0),
+          _left(0), _failed(0), _sweeps(0), _done(nullptr), user(nullptr)
+    {
+    }
+
+public:
+    /**
+     * add a plain read of the device. returns the entry index, or -1 if full or running.
+     */
+    int32_t add(uint8_t addr, void* buf, uint16_t len);
+
+    /**
+     * add a register read of the device. (`i2cm_xfer_t::REG8` or `REG16`)
+     */
+    int32_t add_reg(uint8_t addr, uint16_t reg, void* buf, uint16_t len, uint8_t flags = i2cm_xfer_t::REG8);
+
+    /* remove all entries. fails if running. */
+    bool clear();
+
+    /* get the count of entries. */
+    inline uint8_t count() const { return _count; }
+
+    /**
+     * set the callback, called once from interrupt when a sweep finished.
+     */
+    inline void done(void (*cb)(i2cm_sweep_t* sweep)) { _done = cb; }
+
+    /**
+     * start a sweep. this can be called from interrupt. (e.g. a timer)
+     * returns false if running, or no entries.
+     */
+    bool start();
+
+    /* test whether a sweep is running or not. */
+    inline bool busy() const { return _left != 0; }
+
+    /**
+     * wait for the running sweep to be finished.
+     * this sleeps (WFI) between interrupts if I2CM_WAIT_SLEEP is set.
+     * returns true if all entries succeeded before timeout.
+     */
+    bool wait(uint32_t timeout = 0xffffffffu) const;
+
+    /* test whether the entry succeeded in the last sweep. */
+    inline bool ok(uint8_t i) const { return i < _count && _xfers[i].state == i2cm_xfer_t::DONE; }
+
+    /* get the count of entries failed in the last sweep. */
+    inline uint8_t failed() const { return _failed; }
+
+    /* get the count of sweeps finished. */
+    inline uint32_t sweeps() const { return _sweeps; }
+
+private:
+    /* descriptor callback. */
+    static void on_xfer(i2cm_xfer_t* xfer);
+};
+
+/**
+ * Describes a poll group with its own descriptor storage.
+ */
+template<uint8_t entries>
+class i2cm_sweep_buf_t : public i2cm_sweep_t {
+private:
+    static_assert(entries > 0, "entries must be greater than 0.");
+
+    i2cm_xfer_t _storage[entries];
+
+public:
+    i2cm_sweep_buf_t(i2cm_queue_t& queue) : i2cm_sweep_t(queue, _storage, entries) { }
+};
+
+#endif // __I2CM_SWEEP_H__
@@ -0,0 +1,310 @@
+#include "lzb.h"
+#include <string.h>
+
+static_assert((LZB_WINDOW & (LZB_WINDOW - 1)) == 0 && LZB_WINDOW <= 0x10000,
+    "LZB_WINDOW must be power of 2, and <= 0x10000.");
+
+static inline uint32_t lzb_read32(const uint8_t* p) {
+    uint32_t val;
+    memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+static inline uint32_t lzb_hash(uint32_t val) {
+    return (val * 2654435761u) >> (32 - LZB_HASH_BITS);
+}
+
+static inline uint32_t lzb_min(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+}
+
+uint32_t lzb_encoder_t::encode(const uint8_t* src, uint32_t len, lzb_sink_t& sink) {
+    _sink = &sink;
+    _total = 0;
+
+    // --> positions are stored as low 16 bits, and verified by comparing bytes.
+    memset(_table, 0, sizeof(_table));
+
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* end = src + len;
+    const uint8_t* limit = len > MIN_MATCH ? end - MIN_MATCH : src;
+
+    while (ip < limit) {
+        uint32_t seq = lzb_read32(ip);
+        uint32_t pos = uint32_t(ip - src);
+        uint32_t h = lzb_hash(seq);
+        uint32_t dist = (pos - _table[h]) & 0xffff;
+
+        _table[h] = uint16_t(pos);
+
+        if (dist == 0 || dist >= LZB_WINDOW || dist > pos || lzb_read32(ip - dist) != seq) {
+            // --> skip faster on incompressible data.
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        const uint8_t* ref = ip - dist;
+        uint32_t match = MIN_MATCH;
+
+        while (ip + match < end && ref[match] == ip[match]) {
+            ++match;
+        }
+
+        if (!emit(anchor, uint32_t(ip - anchor), dist, match)) {
+            return 0;
+        }
+
+        ip += match;
+        anchor = ip;
+
+        // --> index the tail of the match to chain repeated runs.
+        if (ip < limit) {
+            _table[lzb_hash(lzb_read32(ip - 2))] = uint16_t(ip - 2 - src);
+        }
+    }
+
+    if (anchor < end && !emit(anchor, uint32_t(end - anchor), 0, 0)) {
+        return 0;
+    }
+
+    return _total;
+}
+
+bool lzb_encoder_t::emit(const uint8_t* lit, uint32_t nlit, uint32_t offset, uint32_t match) {
+    uint8_t token = uint8_t(lzb_min(nlit, 15) << 4);
+    if (match) {
+        token |= uint8_t(lzb_min(match - MIN_MATCH, 15));
+    }
+
+    if (!_sink->put(&token, 1)) {
+        return false;
+    }
+
+    if (nlit >= 15 && !emit_len(nlit - 15)) {
+        return false;
+    }
+
+    if (nlit && !_sink->put(lit, nlit)) {
+        return false;
+    }
+
+    _total += 1 + nlit;
+    if (!match) {
+        return true;
+    }
+
+    uint8_t off[2] = { uint8_t(offset & 0xff), uint8_t(offset >> 8) };
+    if (!_sink->put(off, 2)) {
+        return false;
+    }
+
+    _total += 2;
+    if (match - MIN_MATCH >= 15) {
+        return emit_len(match - MIN_MATCH - 15);
+    }
+
+    return true;
+}
+
+bool lzb_encoder_t::emit_len(uint32_t len) {
+    uint8_t buf[16];
+    uint32_t n = 0;
+
+    while (true) {
+        uint8_t val = uint8_t(lzb_min(len, 255));
+
+        buf[n++] = val;
+        len -= val;
+
+        if (val != 255 || n >= sizeof(buf)) {
+            if (!_sink->put(buf, n)) {
+                return false;
+            }
+
+            _total += n;
+            if (val != 255) {
+                return true;
+            }
+
+            n = 0;
+        }
+    }
+}
+
+void lzb_decoder_t::begin(lzb_source_t& source, uint32_t raw) {
+    _source = &source;
+    _left = raw;
+    _wpos = 0;
+    _count = 0;
+    _offset = 0;
+    _token = 0;
+    _in_pos = _in_len = 0;
+    _state = S_TOKEN;
+}
+
+uint32_t lzb_decoder_t::fill() {
+    if (_in_pos >= _in_len) {
+        _in_pos = 0;
+        _in_len = uint16_t(_source->get(_in, LZB_INPUT));
+    }
+
+    return uint32_t(_in_len - _in_pos);
+}
+
+bool lzb_decoder_t::take(uint8_t& val) {
+    if (!fill()) {
+        return false;
+    }
+
+    val = _in[_in_pos++];
+    return true;
+}
+
+void lzb_decoder_t::put(uint8_t* out, const uint8_t* src, uint32_t len) {
+    uint32_t pos = _wpos & (LZB_WINDOW - 1);
+    uint32_t first = lzb_min(len, LZB_WINDOW - pos);
+
+    // --> output first: `src` can be in the window region that will be overwritten.
+    memcpy(out, src, len);
+    memcpy(_win + pos, out, first);
+    memcpy(_win, out + first, len - first);
+
+    _wpos += len;
+    _left -= len;
+}
+
+uint32_t lzb_decoder_t::read(void* buf, uint32_t len) {
+    uint8_t* out = (uint8_t*) buf;
+    uint32_t done = 0;
+    uint8_t val;
+
+    if (len > _left) {
+        len = _left;
+    }
+
+    while (done < len) {
+        switch (_state) {
+        case S_TOKEN:
+            if (!take(_token)) {
+                _state = S_ERROR;
+                break;
+            }
+
+            _count = _token >> 4;
+            _state = _count == 15 ? S_LITLEN : S_LITERAL;
+            break;
+
+        case S_LITLEN:
+            if (!take(val)) {
+                _state = S_ERROR;
+                break;
+            }
+
+            _count += val;
+            if (val != 255) {
+                _state = S_LITERAL;
+            }
+            break;
+
+        case S_LITERAL:
+            if (!_count) {
+                _state = S_OFFSET_LO;
+            }
+
+            else if (!fill()) {
+                _state = S_ERROR;
+            }
+
+            else {
+                uint32_t n = lzb_min(lzb_min(_count, len - done), fill());
+
+                put(out + done, _in + _in_pos, n);
+                _in_pos += n;
+                _count -= n;
+                done += n;
+            }
+            break;
+
+        case S_OFFSET_LO:
+            if (!take(val)) {
+                _state = S_ERROR;
+                break;
+            }
+
+            _offset = val;
+            _state = S_OFFSET_HI;
+            break;
+
+        case S_OFFSET_HI:
+            if (!take(val)) {
+                _state = S_ERROR;
+                break;
+            }
+
+            _offset |= uint16_t(val) << 8;
+            if (!_offset || _offset >= LZB_WINDOW || _offset > _wpos) {
+                _state = S_ERROR;
+                break;
+            }
+
+            _count = (_token & 0x0f) + lzb_encoder_t::MIN_MATCH;
+            _state = (_token & 0x0f) == 15 ? S_MATCHLEN : S_MATCH;
+            break;
+
+        case S_MATCHLEN:
+            if (!take(val)) {
+                _state = S_ERROR;
+                break;
+            }
+
+            _count += val;
+            if (val != 255) {
+                _state = S_MATCH;
+            }
+            break;
+
+        case S_MATCH:
+            if (!_count) {
+                _state = S_TOKEN;
+            }
+
+            else if (_offset < 16) {
+                // --> short distance (runs): byte by byte.
+                uint32_t n = lzb_min(_count, len - done);
+                const uint32_t mask = LZB_WINDOW - 1;
+
+                for (uint32_t i = 0; i < n; ++i) {
+                    uint8_t b = _win[(_wpos - _offset) & mask];
+
+                    _win[_wpos & mask] = b;
+                    out[done + i] = b;
+                    ++_wpos;
+                }
+
+                _left -= n;
+                _count -= n;
+                done += n;
+            }
+
+            else {
+                // --> copy contiguous, non-overlapping span at once.
+                uint32_t src = (_wpos - _offset) & (LZB_WINDOW - 1);
+                uint32_t n = lzb_min(_count, len - done);
+
+                n = lzb_min(n, _offset);
+                n = lzb_min(n, LZB_WINDOW - src);
+
+                put(out + done, _win + src, n);
+                _count -= n;
+                done += n;
+            }
+            break;
+
+        default:
+            return done;
+        }
+    }
+
+    return done;
+}
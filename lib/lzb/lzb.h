@@ -0,0 +1,143 @@
+#ifndef __LZB_H__
+#define __LZB_H__
+
+#include <stdint.h>
+
+/**
+ * LZB codec configurations.
+ * 1. LZB_WINDOW : max match distance, and decoder RAM. must be power of 2, <= 0x10000.
+ * 2. LZB_HASH_BITS : encoder hash table size. (2 << LZB_HASH_BITS bytes of RAM)
+ * 3. LZB_INPUT : decoder input buffer size.
+ */
+#ifndef LZB_WINDOW
+#define LZB_WINDOW      2048
+#endif
+
+#ifndef LZB_HASH_BITS
+#define LZB_HASH_BITS   10
+#endif
+
+#ifndef LZB_INPUT
+#define LZB_INPUT       64
+#endif
+
+/**
+ * Describes an output of the encoder.
+ */
+class lzb_sink_t {
+public:
+    virtual ~lzb_sink_t() { }
+
+    /* put bytes, returns false to stop encoding. */
+    virtual bool put(const uint8_t* buf, uint32_t len) = 0;
+};
+
+/**
+ * Describes an input of the decoder.
+ */
+class lzb_source_t {
+public:
+    virtual ~lzb_source_t() { }
+
+    /* get bytes, returns read bytes. 0 means end or error. */
+    virtual uint32_t get(uint8_t* buf, uint32_t len) = 0;
+};
+
+/**
+ * LZ4-class encoder with small window.
+ * --
+ * sequence format:
+ *  [token] [literal length ext...] [literals...] [offset: 2 bytes, LE] [match length ext...]
+ *  token: (literal length << 4) | (match length - 4), 15 means extended by 255-chained bytes.
+ *  the last sequence has literals only, the decoder knows its end from the raw size.
+ */
+class lzb_encoder_t {
+public:
+    static constexpr uint32_t MIN_MATCH = 4;
+
+private:
+    uint16_t _table[1 << LZB_HASH_BITS];
+    lzb_sink_t* _sink;
+    uint32_t _total;
+
+public:
+    lzb_encoder_t() : _sink(nullptr), _total(0) { }
+
+public:
+    /**
+     * compress the buffer into the sink.
+     * returns encoded bytes, or 0 if the sink failed.
+     */
+    uint32_t encode(const uint8_t* src, uint32_t len, lzb_sink_t& sink);
+
+private:
+    /* emit a sequence. `match` is 0 for the last sequence. */
+    bool emit(const uint8_t* lit, uint32_t nlit, uint32_t offset, uint32_t match);
+
+    /* emit a length extension. */
+    bool emit_len(uint32_t len);
+};
+
+/**
+ * Streaming LZB decoder.
+ * RAM: LZB_WINDOW + LZB_INPUT bytes.
+ */
+class lzb_decoder_t {
+private:
+    enum state_t : uint8_t {
+        S_TOKEN = 0,
+        S_LITLEN,
+        S_LITERAL,
+        S_OFFSET_LO,
+        S_OFFSET_HI,
+        S_MATCHLEN,
+        S_MATCH,
+        S_ERROR
+    };
+
+private:
+    uint8_t _win[LZB_WINDOW];
+    uint8_t _in[LZB_INPUT];
+    uint16_t _in_pos, _in_len;
+
+    lzb_source_t* _source;
+    uint32_t _left;     // --> bytes left to decode.
+    uint32_t _wpos;     // --> total decoded bytes.
+    uint32_t _count;    // --> literal or match length left.
+    uint16_t _offset;
+    uint8_t _token;
+    state_t _state;
+
+public:
+    lzb_decoder_t() : _source(nullptr), _left(0), _state(S_ERROR) { }
+
+public:
+    /**
+     * reset the decoder to decode `raw` bytes from the source.
+     */
+    void begin(lzb_source_t& source, uint32_t raw);
+
+    /* bytes left to decode. */
+    inline uint32_t left() const { return _left; }
+
+    /* test whether the stream was broken or not. */
+    inline bool error() const { return _state == S_ERROR && _left; }
+
+    /**
+     * decode bytes into the buffer and returns decoded bytes.
+     * returns less than `len` at the end, or on error.
+     */
+    uint32_t read(void* buf, uint32_t len);
+
+private:
+    /* take a byte from input buffer. */
+    bool take(uint8_t& val);
+
+    /* make input bytes available, returns available count. */
+    uint32_t fill();
+
+    /* put decoded bytes into the window and the output. */
+    void put(uint8_t* out, const uint8_t* src, uint32_t len);
+};
+
+#endif // __LZB_H__
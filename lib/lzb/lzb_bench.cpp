@@ -0,0 +1,246 @@
+/**
+ * LZB host benchmark: compression ratio and throughput, against memcpy (and LZ4 if installed).
+ * host only: excluded from ARM builds, so the folder can be copied into the firmware as is.
+ * --
+ * build:
+ *  g++ -O2 -std=c++11 lzb_bench.cpp lzb.cpp -o lzb_bench
+ *  g++ -O2 -std=c++11 lzb_bench.cpp lzb.cpp -o lzb_bench -llz4   (with liblz4-dev, as the baseline)
+ * usage:
+ *  ./lzb_bench [file...]   --> without files, runs on generated samples.
+ */
+#if !defined(__arm__)
+
+#include "lzb.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<lz4.h>)
+#include <lz4.h>
+#define LZB_BENCH_LZ4   1
+#endif
+#endif
+
+#ifndef LZB_BENCH_LZ4
+#define LZB_BENCH_LZ4   0
+#endif
+
+/**
+ * Sink and source on memory.
+ */
+class bench_sink_t : public lzb_sink_t {
+public:
+    std::vector<uint8_t> out;
+
+    virtual bool put(const uint8_t* buf, uint32_t len) override {
+        out.insert(out.end(), buf, buf + len);
+        return true;
+    }
+};
+
+class bench_source_t : public lzb_source_t {
+private:
+    const uint8_t* _buf;
+    uint32_t _len;
+    uint32_t _pos;
+
+public:
+    bench_source_t(const uint8_t* buf, uint32_t len) : _buf(buf), _len(len), _pos(0) { }
+
+    virtual uint32_t get(uint8_t* buf, uint32_t len) override {
+        uint32_t n = _len - _pos < len ? _len - _pos : len;
+        memcpy(buf, _buf + _pos, n);
+        _pos += n;
+        return n;
+    }
+};
+
+struct sample_t {
+    std::string name;
+    std::vector<uint8_t> data;
+};
+
+static double now() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+/* run `fn` repeatedly for about 0.2 seconds, and returns MB/s of `bytes` per run. */
+template<typename fn_t>
+static double measure(uint32_t bytes, fn_t fn) {
+    uint32_t runs = 0;
+    double begin = now(), elapsed;
+
+    do {
+        fn();
+        ++runs;
+    } while ((elapsed = now() - begin) < 0.2);
+
+    return (double(bytes) * runs) / elapsed / 1e6;
+}
+
+// --> generated samples: typical blobs kept in the flash.
+static std::vector<sample_t> generate() {
+    std::vector<sample_t> samples;
+    srand(1);
+
+    // --> configuration text. (key = value lines)
+    sample_t text = { "config text", { } };
+    for (uint32_t i = 0; text.data.size() < 16384; ++i) {
+        char line[96];
+        int n = snprintf(line, sizeof(line), "channel.%u.gain = %d\nchannel.%u.offset = %d\nchannel.%u.name = \"sensor-%u\"\n",
+                         i, rand() % 64, i, rand() % 1000 - 500, i, i % 12);
+        text.data.insert(text.data.end(), line, line + n);
+    }
+    samples.push_back(text);
+
+    // --> sensor log: 16-bit samples of a slow sine, with small noise.
+    sample_t log = { "sensor log (int16)", { } };
+    for (uint32_t i = 0; i < 8192; ++i) {
+        int16_t v = int16_t(1000 * sin(i * 0.01) + (rand() % 5));
+        log.data.push_back(uint8_t(v));
+        log.data.push_back(uint8_t(v >> 8));
+    }
+    samples.push_back(log);
+
+    // --> 1 bpp bitmap: mostly empty, with repeated glyph rows.
+    sample_t bitmap = { "bitmap (1 bpp)", { } };
+    for (uint32_t i = 0; i < 16384; ++i) {
+        bitmap.data.push_back((i % 128) < 16 ? uint8_t(0x18 << (i % 3)) : 0);
+    }
+    samples.push_back(bitmap);
+
+    // --> random: incompressible.
+    sample_t noise = { "random", { } };
+    for (uint32_t i = 0; i < 16384; ++i) {
+        noise.data.push_back(uint8_t(rand()));
+    }
+    samples.push_back(noise);
+
+    return samples;
+}
+
+static bool load(const char* path, sample_t& sample) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+
+    uint8_t buf[4096];
+    size_t n;
+
+    sample.name = path;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        sample.data.insert(sample.data.end(), buf, buf + n);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static bool bench(const sample_t& sample) {
+    const uint8_t* src = sample.data.data();
+    uint32_t len = uint32_t(sample.data.size());
+
+    static lzb_encoder_t enc;
+    static lzb_decoder_t dec;
+    bench_sink_t sink;
+
+    if (!enc.encode(src, len, sink)) {
+        printf("%-20s: encode failed.\n", sample.name.c_str());
+        return false;
+    }
+
+    // --> round trip, in small reads like the flash store.
+    std::vector<uint8_t> out(len);
+    bench_source_t source(sink.out.data(), uint32_t(sink.out.size()));
+    uint32_t got = 0, n;
+
+    dec.begin(source, len);
+    while (got < len && (n = dec.read(out.data() + got, len - got < 256 ? len - got : 256)) > 0) {
+        got += n;
+    }
+
+    if (got != len || memcmp(out.data(), src, len)) {
+        printf("%-20s: round trip FAILED.\n", sample.name.c_str());
+        return false;
+    }
+
+    double enc_mbs = measure(len, [&]() {
+        sink.out.clear();
+        enc.encode(src, len, sink);
+    });
+
+    double dec_mbs = measure(len, [&]() {
+        bench_source_t s(sink.out.data(), uint32_t(sink.out.size()));
+        dec.begin(s, len);
+        for (uint32_t i = 0; i < len; ) {
+            i += dec.read(out.data() + i, len - i);
+        }
+    });
+
+    double copy_mbs = measure(len, [&]() {
+        memcpy(out.data(), src, len);
+        __asm__ __volatile__("" : : "r"(out.data()) : "memory");
+    });
+
+    printf("%-20s %8u %8u %6.1f%% %9.1f %9.1f %9.1f",
+           sample.name.c_str(), len, uint32_t(sink.out.size()),
+           100.0 * sink.out.size() / len, enc_mbs, dec_mbs, copy_mbs);
+
+#if LZB_BENCH_LZ4
+    std::vector<char> lz(LZ4_compressBound(len));
+    int lz_len = LZ4_compress_default((const char*) src, lz.data(), len, int(lz.size()));
+
+    double lz_enc = measure(len, [&]() {
+        LZ4_compress_default((const char*) src, lz.data(), len, int(lz.size()));
+    });
+
+    double lz_dec = measure(len, [&]() {
+        LZ4_decompress_safe(lz.data(), (char*) out.data(), lz_len, len);
+    });
+
+    printf("   | lz4 %6.1f%% %9.1f %9.1f", 100.0 * lz_len / len, lz_enc, lz_dec);
+#endif
+
+    printf("\n");
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::vector<sample_t> samples;
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            sample_t sample;
+            if (!load(argv[i], sample) || sample.data.empty()) {
+                fprintf(stderr, "can not read: %s\n", argv[i]);
+                return 1;
+            }
+
+            samples.push_back(sample);
+        }
+    }
+    else {
+        samples = generate();
+    }
+
+    printf("LZB_WINDOW %u, LZB_HASH_BITS %u. throughput in MB/s.\n\n", LZB_WINDOW, LZB_HASH_BITS);
+    printf("%-20s %8s %8s %7s %9s %9s %9s%s\n", "sample", "raw", "packed", "ratio",
+           "encode", "decode", "memcpy", LZB_BENCH_LZ4 ? "   | lz4  ratio    encode    decode" : "");
+
+    bool ok = true;
+    for (const sample_t& sample : samples) {
+        ok = bench(sample) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
+
+#endif
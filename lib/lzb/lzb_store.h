@@ -0,0 +1,161 @@
+#ifndef __LZB_STORE_H__
+#define __LZB_STORE_H__
+
+// --> LZB codec.
+#include "lzb.h"
+
+// --> write-combining buffer.
+#include "../w25qxx_wc/w25qxx_wc.h"
+
+/**
+ * Describes a blob header on the flash.
+ */
+struct lzb_header_t {
+    static constexpr uint32_t MAGIC = 0x31425a4c; // --> 'LZB1'.
+
+    uint32_t magic;
+    uint32_t raw;       // --> raw size.
+    uint32_t packed;    // --> compressed size, without header.
+    uint32_t window;    // --> LZB_WINDOW used to encode.
+};
+
+/**
+ * Compressed blob store on W25QXX flash.
+ * `T` can be `w25qxx_t` (STM32) or `W25QXX` (RP2040).
+ * --
+ * layout: [lzb_header_t] [compressed bytes...]
+ * the target region must be erased before `store`.
+ */
+template<typename T>
+class lzb_store_t {
+private:
+    /* encoder output to the flash, through write-combining buffer. */
+    class flash_sink_t : public lzb_sink_t {
+    public:
+        w25qxx_wc_t<T>& _wc;
+        uint32_t _addr, _limit;
+
+        flash_sink_t(w25qxx_wc_t<T>& wc, uint32_t addr, uint32_t limit)
+            : _wc(wc), _addr(addr), _limit(limit) { }
+
+        virtual bool put(const uint8_t* buf, uint32_t len) override {
+            if (len > _limit - _addr) {
+                return false;
+            }
+
+            if (_wc.write(_addr, buf, len) != len) {
+                return false;
+            }
+
+            _addr += len;
+            return true;
+        }
+    };
+
+public:
+    /**
+     * compress the buffer and store it at `addr`.
+     * `limit` is the end address of the region. (exclusive)
+     * returns bytes used on the flash, including header. 0 if failed.
+     */
+    static uint32_t store(T& dev, uint32_t addr, uint32_t limit, const void* buf, uint32_t len, lzb_encoder_t& enc) {
+        if (addr + sizeof(lzb_header_t) >= limit) {
+            return 0;
+        }
+
+        w25qxx_wc_t<T> wc(dev);
+        flash_sink_t sink(wc, addr + sizeof(lzb_header_t), limit);
+
+        uint32_t packed = len ? enc.encode((const uint8_t*) buf, len, sink) : 0;
+        if (len && !packed) {
+            wc.discard();
+            return 0;
+        }
+
+        // --> header at last: a blob without header is not valid.
+        lzb_header_t hdr = { lzb_header_t::MAGIC, len, packed, LZB_WINDOW };
+        if (wc.write(addr, &hdr, sizeof(hdr)) != sizeof(hdr) || !wc.flush()) {
+            return 0;
+        }
+
+        return sizeof(hdr) + packed;
+    }
+};
+
+/**
+ * Describes a streaming reader for the compressed blob.
+ * RAM: LZB_WINDOW + LZB_INPUT bytes, and a few more.
+ */
+template<typename T>
+class lzb_reader_t : public lzb_source_t {
+private:
+    T& _dev;
+    uint32_t _addr;     // --> next compressed byte.
+    uint32_t _end;      // --> end of compressed bytes.
+    lzb_header_t _hdr;
+    lzb_decoder_t _dec;
+
+public:
+    lzb_reader_t(T& dev) : _dev(dev), _addr(0), _end(0) {
+        _hdr.magic = 0;
+        _hdr.raw = 0;
+    }
+
+public:
+    /**
+     * open the blob at `addr`.
+     * returns false if no valid blob there.
+     */
+    bool open(uint32_t addr) {
+        if (_dev.read(addr, (uint8_t*) &_hdr, sizeof(_hdr)) != sizeof(_hdr)) {
+            return false;
+        }
+
+        if (_hdr.magic != lzb_header_t::MAGIC || _hdr.window > LZB_WINDOW) {
+            _hdr.magic = 0;
+            return false;
+        }
+
+        _addr = addr + sizeof(_hdr);
+        _end = _addr + _hdr.packed;
+        _dec.begin(*this, _hdr.raw);
+        return true;
+    }
+
+    /* raw size of the blob. */
+    inline uint32_t size() const { return _hdr.raw; }
+
+    /* compressed size of the blob. */
+    inline uint32_t packed() const { return _hdr.packed; }
+
+    /* bytes left to read. */
+    inline uint32_t left() const { return _dec.left(); }
+
+    /* test whether the blob was broken or not. */
+    inline bool error() const { return _dec.error(); }
+
+    /**
+     * read decompressed bytes, returns read bytes.
+     */
+    inline uint32_t read(void* buf, uint32_t len) {
+        return _dec.read(buf, len);
+    }
+
+protected:
+    /* feed compressed bytes to the decoder. */
+    virtual uint32_t get(uint8_t* buf, uint32_t len) override {
+        if (len > _end - _addr) {
+            len = _end - _addr;
+        }
+
+        if (!len) {
+            return 0;
+        }
+
+        len = _dev.read(_addr, buf, len);
+        _addr += len;
+        return len;
+    }
+};
+
+#endif // __LZB_STORE_H__
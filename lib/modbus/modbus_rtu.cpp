@@ -0,0 +1,364 @@
+#include "modbus_rtu.h"
+
+// --> CRC16 (poly 0xa001, reflected), indexed by the low byte.
+static const uint16_t MODBUS_CRC_TABLE[256] = {
+    0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241,
+    0xc601, 0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1, 0xc481, 0x0440,
+    0xcc01, 0x0cc0, 0x0d80, 0xcd41, 0x0f00, 0xcfc1, 0xce81, 0x0e40,
+    0x0a00, 0xcac1, 0xcb81, 0x0b40, 0xc901, 0x09c0, 0x0880, 0xc841,
+    0xd801, 0x18c0, 0x1980, 0xd941, 0x1b00, 0xdbc1, 0xda81, 0x1a40,
+    0x1e00, 0xdec1, 0xdf81, 0x1f40, 0xdd01, 0x1dc0, 0x1c80, 0xdc41,
+    0x1400, 0xd4c1, 0xd581, 0x1540, 0xd701, 0x17c0, 0x1680, 0xd641,
+    0xd201, 0x12c0, 0x1380, 0xd341, 0x1100, 0xd1c1, 0xd081, 0x1040,
+    0xf001, 0x30c0, 0x3180, 0xf141, 0x3300, 0xf3c1, 0xf281, 0x3240,
+    0x3600, 0xf6c1, 0xf781, 0x3740, 0xf501, 0x35c0, 0x3480, 0xf441,
+    0x3c00, 0xfcc1, 0xfd81, 0x3d40, 0xff01, 0x3fc0, 0x3e80, 0xfe41,
+    0xfa01, 0x3ac0, 0x3b80, 0xfb41, 0x3900, 0xf9c1, 0xf881, 0x3840,
+    0x2800, 0xe8c1, 0xe981, 0x2940, 0xeb01, 0x2bc0, 0x2a80, 0xea41,
+    0xee01, 0x2ec0, 0x2f80, 0xef41, 0x2d00, 0xedc1, 0xec81, 0x2c40,
+    0xe401, 0x24c0, 0x2580, 0xe541, 0x2700, 0xe7c1, 0xe681, 0x2640,
+    0x2200, 0xe2c1, 0xe381, 0x2340, 0xe101, 0x21c0, 0x2080, 0xe041,
+    0xa001, 0x60c0, 0x6180, 0xa141, 0x6300, 0xa3c1, 0xa281, 0x6240,
+    0x6600, 0xa6c1, 0xa781, 0x6740, 0xa501, 0x65c0, 0x6480, 0xa441,
+    0x6c00, 0xacc1, 0xad81, 0x6d40, 0xaf01, 0x6fc0, 0x6e80, 0xae41,
+    0xaa01, 0x6ac0, 0x6b80, 0xab41, 0x6900, 0xa9c1, 0xa881, 0x6840,
+    0x7800, 0xb8c1, 0xb981, 0x7940, 0xbb01, 0x7bc0, 0x7a80, 0xba41,
+    0xbe01, 0x7ec0, 0x7f80, 0xbf41, 0x7d00, 0xbdc1, 0xbc81, 0x7c40,
+    0xb401, 0x74c0, 0x7580, 0xb541, 0x7700, 0xb7c1, 0xb681, 0x7640,
+    0x7200, 0xb2c1, 0xb381, 0x7340, 0xb101, 0x71c0, 0x7080, 0xb041,
+    0x5000, 0x90c1, 0x9181, 0x5140, 0x9301, 0x53c0, 0x5280, 0x9241,
+    0x9601, 0x56c0, 0x5780, 0x9741, 0x5500, 0x95c1, 0x9481, 0x5440,
+    0x9c01, 0x5cc0, 0x5d80, 0x9d41, 0x5f00, 0x9fc1, 0x9e81, 0x5e40,
+    0x5a00, 0x9ac1, 0x9b81, 0x5b40, 0x9901, 0x59c0, 0x5880, 0x9841,
+    0x8801, 0x48c0, 0x4980, 0x8941, 0x4b00, 0x8bc1, 0x8a81, 0x4a40,
+    0x4e00, 0x8ec1, 0x8f81, 0x4f40, 0x8d01, 0x4dc0, 0x4c80, 0x8c41,
+    0x4400, 0x84c1, 0x8581, 0x4540, 0x8701, 0x47c0, 0x4680, 0x8641,
+    0x8201, 0x42c0, 0x4380, 0x8341, 0x4100, 0x81c1, 0x8081, 0x4040,
+};
+
+uint16_t modbus_rtu_t::crc16(const uint8_t* buf, uint32_t len, uint16_t crc) {
+    while (len--) {
+        crc = (crc >> 8) ^ MODBUS_CRC_TABLE[(crc ^ *buf++) & 0xff];
+    }
+
+    return crc;
+}
+
+void modbus_rtu_t::bind(modbus_map_t& map) {
+    map.next = _maps;
+    _maps = &map;
+}
+
+bool modbus_rtu_t::begin(ring_t& rx, ring_t& tx) {
+    if (_rx) {
+        return false;
+    }
+
+    _rx = &rx;
+    if (!begin_ring(rx)) {
+        _rx = nullptr;
+        return false;
+    }
+
+    if (!begin_tx(tx)) {
+        end_ring();
+        _rx = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void modbus_rtu_t::on_event(uint16_t pos) {
+#ifdef HAL_UART_RXEVENT_IDLE
+    (void) pos;
+    _idle = HAL_UARTEx_GetRxEventType(handle()) == HAL_UART_RXEVENT_IDLE;
+#else
+    // --> HAL without the event type: half and full are at the fixed positions.
+    _idle = _rx && pos != _rx->size() / 2 && pos != _rx->size();
+#endif
+
+    uart_base_t::on_event(pos);
+}
+
+void modbus_rtu_t::on_ring_intr() {
+    if (!_rx) {
+        return;
+    }
+
+    while (true) {
+        uint32_t n = _rx->peek(_buf, sizeof(_buf));
+        if (n < 4) {
+            if (n && _idle) {
+                _rx->consume(n);
+                _errors += n;
+            }
+
+            break;
+        }
+
+        uint32_t len = length(_buf, n);
+        if (!len) {
+            // --> unknown function: only the IDLE line ends it.
+            if (!_idle) {
+                break;
+            }
+
+            len = n;
+            if (crc16(_buf, len)) {
+                _rx->consume(n);
+                _errors += n;
+                break;
+            }
+        }
+
+        else if (len > sizeof(_buf)) {
+            _rx->consume(1);
+            _errors++;
+            continue;
+        }
+
+        else if (len > n) {
+            // --> incomplete: more than 1.5 char gap in the frame is an error.
+            if (_idle) {
+                _rx->consume(n);
+                _errors += n;
+            }
+
+            break;
+        }
+
+        else if (crc16(_buf, len)) {
+            // --> re-sync from the next byte.
+            _rx->consume(1);
+            _errors++;
+            continue;
+        }
+
+        _rx->consume(len);
+
+        uint8_t addr = _buf[0];
+        if (addr != _addr && addr != 0) {
+            continue;
+        }
+
+        _frames++;
+        uint32_t out = handle(_buf, len);
+
+        // --> no response to the broadcast.
+        if (addr) {
+            reply(_buf, out);
+        }
+    }
+}
+
+void modbus_rtu_t::on_sent() {
+    uart_base_t::on_sent();
+
+    if (!pending()) {
+        _de.write(low);
+    }
+}
+
+uint32_t modbus_rtu_t::length(const uint8_t* buf, uint32_t len) {
+    switch (buf[1]) {
+        case 0x01: case 0x02: case 0x03:
+        case 0x04: case 0x05: case 0x06:
+            return 8;
+
+        case 0x0f: case 0x10:
+            return len < 7 ? 7 : 9 + buf[6];
+
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+modbus_map_t* modbus_rtu_t::find(uint8_t type, uint16_t addr, uint16_t count) const {
+    for (modbus_map_t* map = _maps; map; map = map->next) {
+        if (map->type == type && addr >= map->start &&
+            uint32_t(addr) + count <= uint32_t(map->start) + map->count)
+        {
+            return map;
+        }
+    }
+
+    return nullptr;
+}
+
+/* make the exception response. */
+static inline uint32_t modbus_except(uint8_t* res, uint8_t code) {
+    res[1] |= 0x80;
+    res[2] = code;
+    return 3;
+}
+
+uint32_t modbus_rtu_t::handle(uint8_t* buf, uint32_t len) {
+    uint8_t fn = buf[1];
+    uint16_t addr = (uint16_t(buf[2]) << 8) | buf[3];
+    uint16_t qty = (uint16_t(buf[4]) << 8) | buf[5];    // --> or value.
+    modbus_map_t* map;
+
+    // --> the response is built in place: the header is parsed above.
+    buf[0] = _addr;
+    (void) len;
+
+    switch (fn) {
+        case 0x01:
+            return read_bits(modbus_map_t::COIL, addr, qty, buf);
+
+        case 0x02:
+            return read_bits(modbus_map_t::DISCRETE, addr, qty, buf);
+
+        case 0x03:
+            return read_regs(modbus_map_t::HOLDING, addr, qty, buf);
+
+        case 0x04:
+            return read_regs(modbus_map_t::INPUT, addr, qty, buf);
+
+        case 0x05:
+            if (qty != 0xff00 && qty != 0x0000) {
+                return modbus_except(buf, ILLEGAL_VALUE);
+            }
+
+            if (!(map = find(modbus_map_t::COIL, addr, 1))) {
+                return modbus_except(buf, ILLEGAL_ADDRESS);
+            }
+            else {
+                uint8_t* bits = (uint8_t*) map->data;
+                uint32_t i = addr - map->start;
+
+                if (qty) bits[i >> 3] |= uint8_t(1u << (i & 7));
+                else bits[i >> 3] &= uint8_t(~(1u << (i & 7)));
+            }
+
+            on_write(*map, addr, 1);
+            return 6; // --> echo.
+
+        case 0x06:
+            if (!(map = find(modbus_map_t::HOLDING, addr, 1))) {
+                return modbus_except(buf, ILLEGAL_ADDRESS);
+            }
+
+            ((uint16_t*) map->data)[addr - map->start] = qty;
+            on_write(*map, addr, 1);
+            return 6; // --> echo.
+
+        case 0x0f:
+            if (!qty || qty > 1968 || buf[6] != (qty + 7) / 8) {
+                return modbus_except(buf, ILLEGAL_VALUE);
+            }
+
+            if (!(map = find(modbus_map_t::COIL, addr, qty))) {
+                return modbus_except(buf, ILLEGAL_ADDRESS);
+            }
+            else {
+                uint8_t* bits = (uint8_t*) map->data;
+                uint32_t base = addr - map->start;
+
+                for (uint32_t k = 0; k < qty; ++k) {
+                    uint32_t i = base + k;
+
+                    if (buf[7 + (k >> 3)] & (1u << (k & 7))) bits[i >> 3] |= uint8_t(1u << (i & 7));
+                    else bits[i >> 3] &= uint8_t(~(1u << (i & 7)));
+                }
+            }
+
+            on_write(*map, addr, qty);
+            return 6; // --> address and quantity.
+
+        case 0x10:
+            if (!qty || qty > 123 || buf[6] != qty * 2) {
+                return modbus_except(buf, ILLEGAL_VALUE);
+            }
+
+            if (!(map = find(modbus_map_t::HOLDING, addr, qty))) {
+                return modbus_except(buf, ILLEGAL_ADDRESS);
+            }
+            else {
+                uint16_t* regs = (uint16_t*) map->data + (addr - map->start);
+                const uint8_t* src = buf + 7;
+
+                for (uint32_t k = 0; k < qty; ++k, src += 2) {
+                    regs[k] = (uint16_t(src[0]) << 8) | src[1];
+                }
+            }
+
+            on_write(*map, addr, qty);
+            return 6; // --> address and quantity.
+
+        default:
+            break;
+    }
+
+    return modbus_except(buf, ILLEGAL_FUNCTION);
+}
+
+uint32_t modbus_rtu_t::read_bits(uint8_t type, uint16_t addr, uint16_t qty, uint8_t* res) {
+    if (!qty || qty > 2000) {
+        return modbus_except(res, ILLEGAL_VALUE);
+    }
+
+    modbus_map_t* map = find(type, addr, qty);
+    if (!map) {
+        return modbus_except(res, ILLEGAL_ADDRESS);
+    }
+
+    const uint8_t* bits = (const uint8_t*) map->data;
+    uint32_t base = addr - map->start;
+    uint32_t bytes = (qty + 7) / 8;
+
+    res[2] = uint8_t(bytes);
+    memset(res + 3, 0, bytes);
+
+    for (uint32_t k = 0; k < qty; ++k) {
+        uint32_t i = base + k;
+
+        if (bits[i >> 3] & (1u << (i & 7))) {
+            res[3 + (k >> 3)] |= uint8_t(1u << (k & 7));
+        }
+    }
+
+    return 3 + bytes;
+}
+
+uint32_t modbus_rtu_t::read_regs(uint8_t type, uint16_t addr, uint16_t qty, uint8_t* res) {
+    if (!qty || qty > 125) {
+        return modbus_except(res, ILLEGAL_VALUE);
+    }
+
+    modbus_map_t* map = find(type, addr, qty);
+    if (!map) {
+        return modbus_except(res, ILLEGAL_ADDRESS);
+    }
+
+    const uint16_t* regs = (const uint16_t*) map->data + (addr - map->start);
+    uint8_t* dst = res + 3;
+
+    res[2] = uint8_t(qty * 2);
+    for (uint32_t k = 0; k < qty; ++k) {
+        uint16_t v = regs[k];
+
+        *dst++ = uint8_t(v >> 8);
+        *dst++ = uint8_t(v);
+    }
+
+    return 3 + qty * 2;
+}
+
+void modbus_rtu_t::reply(uint8_t* res, uint32_t len) {
+    uint16_t crc = crc16(res, len);
+
+    res[len++] = uint8_t(crc);
+    res[len++] = uint8_t(crc >> 8);
+
+    // --> the whole response, or nothing: the master will retry.
+    if (writable() < len) {
+        return;
+    }
+
+    _de.write(high);
+    write(res, len);
+}
@@ -0,0 +1,145 @@
+#ifndef __MODBUS_RTU_H__
+#define __MODBUS_RTU_H__
+
+#include "../uart/uart.h"
+#include "../pin/pin.h"
+
+#if !UART_USE_RING
+#error "modbus_rtu requires UART_USE_RING = 1."
+#endif
+
+// --> max RTU frame length. (ADU)
+//   : responses to the largest reads take 255 bytes, so this can not be less than 256.
+#ifndef MODBUS_RTU_MAX
+#define MODBUS_RTU_MAX      256
+#endif
+
+#if MODBUS_RTU_MAX < 256
+#error "MODBUS_RTU_MAX must be 256 or more."
+#endif
+
+/**
+ * Describes a register map, bound to the application memory directly. (no copy)
+ * coils and discrete inputs are bit arrays, LSB first. registers are native uint16_t.
+ */
+struct modbus_map_t {
+    static constexpr uint8_t COIL = 0;      // --> 0x01 read, 0x05/0x0f write.
+    static constexpr uint8_t DISCRETE = 1;  // --> 0x02 read.
+    static constexpr uint8_t HOLDING = 2;   // --> 0x03 read, 0x06/0x10 write.
+    static constexpr uint8_t INPUT = 3;     // --> 0x04 read.
+
+    uint8_t type;
+    uint16_t start;
+    uint16_t count;
+    void* data;
+    modbus_map_t* next;
+
+    modbus_map_t(uint8_t type, uint16_t start, uint16_t count, void* data)
+        : type(type), start(start), count(count), data(data), next(nullptr)
+    {
+    }
+};
+
+/**
+ * Describes a Modbus RTU slave on the UART.
+ * frames are received by the RX ring (circular DMA), and handled in the IDLE line interrupt,
+ * and responses are queued to the TX queue. (DMA)
+ * --
+ * the request length is known from the function code, so the frame ends without the 3.5 char timer.
+ * the IDLE line (1 char) only discards incomplete bytes, and the CRC re-syncs the rest.
+ */
+class modbus_rtu_t : public uart_base_t {
+public:
+    static constexpr uint8_t ILLEGAL_FUNCTION = 0x01;
+    static constexpr uint8_t ILLEGAL_ADDRESS = 0x02;
+    static constexpr uint8_t ILLEGAL_VALUE = 0x03;
+
+private:
+    uint8_t _addr;
+    ring_t* _rx;
+    modbus_map_t* _maps;
+    pin_t _de;
+
+    bool _idle;         // --> the last RX event was IDLE line.
+    uint32_t _frames;
+    uint32_t _errors;
+
+    uint8_t _buf[MODBUS_RTU_MAX];   // --> request, and the response built in place.
+
+public:
+    /**
+     * initialize a new Modbus RTU slave with its address. (1 ~ 247)
+     */
+    modbus_rtu_t(huart_t uart, uint8_t addr)
+        : uart_base_t(uart), _addr(addr), _rx(nullptr), _maps(nullptr),
+          _idle(false), _frames(0), _errors(0)
+    {
+    }
+
+public:
+    /* compute the Modbus CRC16. (table driven) */
+    static uint16_t crc16(const uint8_t* buf, uint32_t len, uint16_t crc = 0xffff);
+
+public:
+    /* get the slave address. */
+    inline uint8_t address() const { return _addr; }
+
+    /* get the count of requests handled. */
+    inline uint32_t frames() const { return _frames; }
+
+    /* get the count of bytes discarded by CRC error or incomplete frame. */
+    inline uint32_t errors() const { return _errors; }
+
+    /**
+     * set the RS-485 driver enable pin.
+     * this is set high while the response is being sent, and low on the TX complete. (TC)
+     */
+    inline void de(const pin_t& pin) { _de = pin; _de.write(low); }
+
+    /**
+     * bind the register map. call this before `begin`.
+     * overlapped maps of the same type are not allowed.
+     */
+    void bind(modbus_map_t& map);
+
+    /**
+     * start the slave on the rings.
+     * the RX DMA channel must be circular, and the TX DMA channel must be normal.
+     */
+    bool begin(ring_t& rx, ring_t& tx);
+
+protected:
+    /**
+     * called from interrupt when the master wrote coils or registers.
+     * the map already has the new values.
+     */
+    virtual void on_write(const modbus_map_t& map, uint16_t addr, uint16_t count) {
+        (void) map; (void) addr; (void) count;
+    }
+
+protected:
+    virtual void on_event(uint16_t pos) override;
+    virtual void on_ring_intr() override;
+    virtual void on_sent() override;
+
+private:
+    /* get the request length from the header, 0 if unknown function. */
+    static uint32_t length(const uint8_t* buf, uint32_t len);
+
+    /* find the map that covers [addr, addr + count). */
+    modbus_map_t* find(uint8_t type, uint16_t addr, uint16_t count) const;
+
+    /* handle the request in place, and returns the response length. (without CRC) */
+    uint32_t handle(uint8_t* buf, uint32_t len);
+
+    /* read bits into the response. */
+    uint32_t read_bits(uint8_t type, uint16_t addr, uint16_t qty, uint8_t* res);
+
+    /* read registers into the response. */
+    uint32_t read_regs(uint8_t type, uint16_t addr, uint16_t qty, uint8_t* res);
+
+    /* queue the response with CRC. */
+    void reply(uint8_t* res, uint32_t len);
+};
+
+#endif // __MODBUS_RTU_H__
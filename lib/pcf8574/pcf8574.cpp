@@ -1,12 +1,32 @@
 #include "PCF8574.h"
 
+pcf8574_t* pcf8574_t::_root = nullptr;
+
 pcf8574_t::pcf8574_t(const i2cm_t& i2c)
 	: _i2c(i2c), _began(0),
 	  _stateIn(0xff), _stateOut(0xff),
-	  _timeIn(10), _timeOut(10)
+	  _timeIn(10), _timeOut(10),
+	  _cache(0), _stale(1), _link(nullptr)
 {
 }
 
+pcf8574_t::~pcf8574_t() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	pcf8574_t** temp = &_root;
+	while (*temp) {
+		if (*temp == this) {
+			*temp = _link;
+			break;
+		}
+
+		temp = &(*temp)->_link;
+	}
+
+	__set_PRIMASK(primask);
+}
+
 bool pcf8574_t::flush() {
 	return _i2c.write(&_stateOut, sizeof(_stateOut), _timeOut);
 }
@@ -26,7 +46,13 @@ bool pcf8574_t::begin() {
 		return false;
 	}
 
-	if (receive() == false) {
+	// --> cached inputs are still valid.
+	if (_cache && !_stale) {
+		_began = true;
+		return true;
+	}
+
+	if ((_cache ? refresh() : receive()) == false) {
 		return false;
 	}
 
@@ -69,8 +95,65 @@ bool pcf8574_t::read(uint8_t pin) {
 	uint8_t mask = (1 << pin);
 
 	if (!_began) {
-		receive();
+		if (!_cache) {
+			receive();
+		}
+
+		else if (_stale) {
+			refresh();
+		}
 	}
 
 	return (_stateIn & mask) != 0;
 }
+
+pcf8574_t& pcf8574_t::cache(bool enable) {
+	_cache = enable;
+	_stale = 1;
+	return *this;
+}
+
+pcf8574_t& pcf8574_t::interrupt(const pin_t& pin) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	_int = pin;
+
+	pcf8574_t* temp = _root;
+	while (temp && temp != this) {
+		temp = temp->_link;
+	}
+
+	if (!temp) {
+		_link = _root;
+		_root = this;
+	}
+
+	__set_PRIMASK(primask);
+	return cache(true);
+}
+
+bool pcf8574_t::refresh() {
+	// --> clear first: an edge while reading marks it again.
+	_stale = 0;
+
+	if (receive() == false) {
+		_stale = 1;
+		return false;
+	}
+
+	// --> another chip on the shared line may hold it low, so no edge would come.
+	if (_int.port() && _int.read() == low) {
+		_stale = 1;
+	}
+
+	return true;
+}
+
+void pcf8574_t::exti(uint16_t pin) {
+	for (pcf8574_t* temp = _root; temp; temp = temp->_link) {
+		if (temp->_int.pin() == pin) {
+			temp->_stale = 1;
+		}
+	}
+}
@@ -2,6 +2,7 @@
 #define __PCF8574_H__
 
 #include "../i2cm/i2cm.h"
+#include "../pin/pin.h"
 
 class pcf8574_t {
 private:
@@ -11,8 +12,18 @@ private:
 	uint8_t _stateOut;
 	uint8_t _timeIn, _timeOut;
 
+	/* input cache. */
+	uint8_t _cache;
+	volatile uint8_t _stale;
+	pin_t _int;
+
+	/* instances with INT pin, for `exti`. */
+	static pcf8574_t* _root;
+	pcf8574_t* _link;
+
 public:
 	pcf8574_t(const i2cm_t& i2c);
+	~pcf8574_t();
 
 private:
 	bool flush();
@@ -34,6 +45,38 @@ public:
 	/* read a pin.*/
 	bool read(uint8_t pin);
 
+public:
+	/**
+	 * enable (or disable) the input cache.
+	 * `read` is served from the cache, and reads the chip only when stale.
+	 */
+	pcf8574_t& cache(bool enable);
+
+	/**
+	 * set the INT pin (open-drain, active low), and enable the input cache.
+	 * the pin should be EXTI on the falling edge, and call `exti` from its callback.
+	 * several chips can share an INT line.
+	 */
+	pcf8574_t& interrupt(const pin_t& pin);
+
+	/* mark the input cache stale. safe to call from interrupt. */
+	inline void notify() { _stale = 1; }
+
+	/* test whether the input cache is stale or not. */
+	inline bool stale() const { return _stale != 0; }
+
+	/**
+	 * read the inputs into the cache now.
+	 * the cache stays stale if failed, or the INT line is still asserted.
+	 */
+	bool refresh();
+
+	/**
+	 * mark the chips on the EXTI line stale.
+	 * call this from `HAL_GPIO_EXTI_Callback(GPIO_Pin)`.
+	 */
+	static void exti(uint16_t pin);
+
 };
 
 #endif // __PCF8574_H__
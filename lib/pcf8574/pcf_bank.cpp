@@ -0,0 +1,175 @@
+#include "pcf_bank.h"
+
+pcf_bank_t::pcf_bank_t(pcf_chip_t* chips, uint8_t max)
+	: _chips(chips), _max(max), _count(0), _pins(0), _timeout(10)
+{
+}
+
+pcf_chip_t* pcf_bank_t::find(uint8_t pin) const {
+	for (uint8_t i = 0; i < _count; ++i) {
+		pcf_chip_t& chip = _chips[i];
+
+		if (pin >= chip.base && pin < chip.base + chip.width) {
+			return &chip;
+		}
+	}
+
+	return nullptr;
+}
+
+pcf_bank_t& pcf_bank_t::timeout(uint8_t timeout) {
+	_timeout = timeout;
+	return *this;
+}
+
+int32_t pcf_bank_t::add(const i2cm_t& i2c, uint8_t width) {
+	if (_count >= _max || (width != 8 && width != 16) || _pins + width > MAX_PINS) {
+		return -1;
+	}
+
+	pcf_chip_t& chip = _chips[_count++];
+
+	chip.i2c = i2c;
+	chip.width = width;
+	chip.base = _pins;
+	chip.synced = 0;
+	chip.out = chip.sent = 0xffff;
+	chip.in = 0xffff;
+
+	_pins += width;
+	return chip.base;
+}
+
+pcf_bank_t& pcf_bank_t::write(uint8_t pin, bool state) {
+	pcf_chip_t* chip = find(pin);
+	if (!chip) {
+		return *this;
+	}
+
+	uint16_t mask = 1 << (pin - chip->base);
+
+	if (state) {
+		chip->out |= mask;
+	}
+	else {
+		chip->out &= ~mask;
+	}
+
+	return *this;
+}
+
+pcf_bank_t& pcf_bank_t::write_mask(uint8_t first, uint32_t mask, uint32_t value) {
+	for (uint8_t i = 0; i < _count; ++i) {
+		pcf_chip_t& chip = _chips[i];
+		int32_t shift = int32_t(chip.base) - first;
+		uint32_t m, v;
+
+		// --> align the bits to the chip.
+		if (shift >= 0) {
+			if (shift >= 32) {
+				continue;
+			}
+
+			m = mask >> shift;
+			v = value >> shift;
+		}
+
+		else {
+			if (-shift >= chip.width) {
+				continue;
+			}
+
+			m = mask << -shift;
+			v = value << -shift;
+		}
+
+		m &= (1u << chip.width) - 1;
+		chip.out = uint16_t((chip.out & ~m) | (v & m));
+	}
+
+	return *this;
+}
+
+bool pcf_bank_t::flush(bool force) {
+	bool ret = true;
+
+	for (uint8_t i = 0; i < _count; ++i) {
+		pcf_chip_t& chip = _chips[i];
+		if (chip.synced && chip.out == chip.sent && !force) {
+			continue;
+		}
+
+		// --> PCF8575: P07 ~ P00 first, then P17 ~ P10.
+		uint16_t out = chip.out;
+		uint8_t buf[2] = { uint8_t(out), uint8_t(out >> 8) };
+
+		if (chip.i2c.write(buf, chip.width / 8, _timeout)) {
+			chip.sent = out;
+			chip.synced = 1;
+		}
+
+		else {
+			ret = false;
+		}
+	}
+
+	return ret;
+}
+
+bool pcf_bank_t::read_all(uint8_t* buf) {
+	bool ret = true;
+
+	for (uint8_t i = 0; i < _count; ++i) {
+		pcf_chip_t& chip = _chips[i];
+		uint8_t temp[2];
+
+		if (chip.i2c.read(temp, chip.width / 8, _timeout)) {
+			chip.in = chip.width == 16 ? uint16_t(temp[0] | (temp[1] << 8)) : temp[0];
+		}
+
+		else {
+			ret = false;
+		}
+
+		if (buf) {
+			buf[chip.base / 8] = uint8_t(chip.in);
+
+			if (chip.width == 16) {
+				buf[chip.base / 8 + 1] = uint8_t(chip.in >> 8);
+			}
+		}
+	}
+
+	return ret;
+}
+
+bool pcf_bank_t::read(uint8_t pin) const {
+	pcf_chip_t* chip = find(pin);
+	if (!chip) {
+		return false;
+	}
+
+	return (chip->in & (1 << (pin - chip->base))) != 0;
+}
+
+uint32_t pcf_bank_t::read_mask(uint8_t first) const {
+	uint32_t value = 0;
+
+	for (uint8_t i = 0; i < _count; ++i) {
+		const pcf_chip_t& chip = _chips[i];
+		int32_t shift = int32_t(chip.base) - first;
+		uint32_t in = chip.in & ((1u << chip.width) - 1);
+
+		if (shift >= 0) {
+			if (shift < 32) {
+				value |= in << shift;
+			}
+		}
+
+		else if (-shift < chip.width) {
+			value |= in >> -shift;
+		}
+	}
+
+	return value;
+}
@@ -0,0 +1,102 @@
+#ifndef __PCF_BANK_H__
+#define __PCF_BANK_H__
+
+#include "../i2cm/i2cm.h"
+
+/**
+ * Describes an expander chip in the bank.
+ */
+struct pcf_chip_t {
+	i2cm_t i2c;
+	uint8_t width;		// --> 8: PCF8574, 16: PCF8575.
+	uint8_t base;		// --> the first pin in the bank.
+	uint8_t synced;		// --> `sent` is on the chip.
+	uint16_t out;
+	uint16_t sent;
+	uint16_t in;
+};
+
+/**
+ * Describes a virtual GPIO bank over PCF8574 (8 pins) and PCF8575 (16 pins) chips.
+ * pins are numbered in the order of `add`, up to 128.
+ * writes go to the shadow, and `flush` sends only the chips changed.
+ * the storage is provided by `pcf_bank_buf_t<chips>`.
+ * --
+ * the pins are quasi-bidirectional: keep the pins used as inputs high.
+ */
+class pcf_bank_t {
+public:
+	static constexpr uint8_t MAX_PINS = 128;
+
+private:
+	pcf_chip_t* _chips;
+	uint8_t _max;
+	uint8_t _count;
+	uint8_t _pins;
+	uint8_t _timeout;
+
+public:
+	pcf_bank_t(pcf_chip_t* chips, uint8_t max);
+
+private:
+	/* find the chip of the pin. */
+	pcf_chip_t* find(uint8_t pin) const;
+
+public:
+	/* set timeout of each transfer. */
+	pcf_bank_t& timeout(uint8_t timeout);
+
+	/**
+	 * add a chip, and returns its first pin, or -1 if full.
+	 * `width`: 8 for PCF8574, 16 for PCF8575. all outputs start high.
+	 */
+	int32_t add(const i2cm_t& i2c, uint8_t width = 8);
+
+	/* get the count of pins. */
+	inline uint8_t pins() const { return _pins; }
+
+	/* set a pin in the shadow. */
+	pcf_bank_t& write(uint8_t pin, bool state);
+
+	/**
+	 * set the pins from `first`: bit n of `mask` selects the pin `first + n`, to bit n of `value`.
+	 * e.g. write_mask(8, 0xff00, 0x5a00) --> pins 16 ~ 23.
+	 */
+	pcf_bank_t& write_mask(uint8_t first, uint32_t mask, uint32_t value);
+
+	/**
+	 * write the chips whose outputs differ from the last written. (all chips, if `force`)
+	 * failed chips are kept to retry, and returns false.
+	 */
+	bool flush(bool force = false);
+
+	/**
+	 * read all chips into the input cache, and copy the pins packed to `buf` if given.
+	 * (pin n: bit (n % 8) of buf[n / 8], `pins() / 8` bytes)
+	 * returns false if any chip failed, and its cache is kept.
+	 */
+	bool read_all(uint8_t* buf = nullptr);
+
+	/* read a pin from the input cache. (`read_all`) */
+	bool read(uint8_t pin) const;
+
+	/* read 32 pins from `first`, from the input cache. */
+	uint32_t read_mask(uint8_t first) const;
+};
+
+/**
+ * Describes a bank with its own chip storage.
+ * e.g. pcf_bank_buf_t<8> --> up to 8 chips.
+ */
+template<uint8_t chips>
+class pcf_bank_buf_t : public pcf_bank_t {
+private:
+	static_assert(chips > 0 && chips <= 16, "chips must be 1 ~ 16.");
+
+	pcf_chip_t _storage[chips];
+
+public:
+	pcf_bank_buf_t() : pcf_bank_t(_storage, chips) { }
+};
+
+#endif // __PCF_BANK_H__
@@ -1,4 +1,4 @@
-#include "Pin.h"
+#include "pin.h"
 
 void __attribute__((optimize("O0"))) pin_t::delay() {
     for(uint32_t i = 0; i < 10; ++i);
@@ -0,0 +1,262 @@
+#ifndef __RING_H__
+#define __RING_H__
+
+#include <stdint.h>
+#include <string.h>
+
+// --> compiler barrier between data and index accesses. (single core)
+#ifndef RING_BARRIER
+#define RING_BARRIER()  __asm__ volatile ("" ::: "memory")
+#endif
+
+/**
+ * Describes a single-producer/single-consumer byte ring on external storage.
+ * the size must be power of 2, and the indices are monotonic, wrapped by the mask.
+ * --
+ * producer: `back`, `commit`, `write`, `restart`. (e.g. interrupt, DMA)
+ * consumer: `front`, `consume`, `read`, `peek`. (e.g. thread)
+ * the producer may commit more than free space when it can not stop. (e.g. circular DMA)
+ * then, the consumer drops the oldest bytes on its next access, and counts them.
+ */
+class ring_t {
+private:
+    uint8_t* _buf;
+    uint32_t _mask;
+
+    volatile uint32_t _head;    // --> producer.
+    volatile uint32_t _floor;   // --> producer, the consumer must not be behind this.
+    volatile uint32_t _tail;    // --> consumer.
+    volatile uint32_t _seen;    // --> consumer, the floor applied last.
+    uint32_t _dropped;          // --> consumer.
+
+public:
+    /**
+     * initialize a new ring on the storage.
+     * `size` must be power of 2.
+     */
+    ring_t(void* buf, uint32_t size)
+        : _buf((uint8_t*) buf), _mask(size - 1), _head(0), _floor(0), _tail(0), _seen(0), _dropped(0)
+    {
+    }
+
+public:
+    /* get the storage. */
+    inline uint8_t* data() const { return _buf; }
+
+    /* get the storage size in bytes. */
+    inline uint32_t size() const { return _mask + 1; }
+
+    /* get the producer index. */
+    inline uint32_t head() const { return _head; }
+
+    /* get the consumer index. */
+    inline uint32_t tail() const { return _tail; }
+
+    /**
+     * get the count of readable bytes. bytes discarded by restart are excluded already.
+     * this can be larger than `size()` if overrun, until the consumer accesses.
+     */
+    inline uint32_t count() const {
+        uint32_t head, floor;
+        uint32_t tail = start(head, floor);
+        return head - tail;
+    }
+
+    /* get the count of writable bytes. */
+    inline uint32_t space() const {
+        uint32_t n = count();
+        return n < size() ? size() - n : 0;
+    }
+
+    /* test whether the ring is empty or not. */
+    inline bool empty() const { return count() == 0; }
+
+    /* test whether the ring is full or not. */
+    inline bool full() const { return count() >= size(); }
+
+    /* get the count of bytes skipped by overrun or restart. (restart also skips the unused rest of storage) */
+    inline uint32_t dropped() const { return _dropped; }
+
+public: // --> producer.
+    /**
+     * get the contiguous writable span at head.
+     * `len` receives the span length, limited by the free space.
+     */
+    inline uint8_t* back(uint32_t& len) const {
+        uint32_t pos = _head & _mask;
+        uint32_t n = size() - pos;
+        uint32_t s = space();
+
+        len = n < s ? n : s;
+        return _buf + pos;
+    }
+
+    /* publish `len` bytes written at head. */
+    inline void commit(uint32_t len) {
+        RING_BARRIER();
+        _head = _head + len;
+    }
+
+    /**
+     * write bytes, and returns written bytes. (limited by the free space)
+     */
+    inline uint32_t write(const void* buf, uint32_t len) {
+        const uint8_t* src = (const uint8_t*) buf;
+        uint32_t total = 0;
+
+        while (total < len) {
+            uint32_t n;
+            uint8_t* dst = back(n);
+
+            if (!n) {
+                break;
+            }
+
+            if (n > len - total) {
+                n = len - total;
+            }
+
+            memcpy(dst, src + total, n);
+            commit(n);
+            total += n;
+        }
+
+        return total;
+    }
+
+    /**
+     * discard all unread bytes, and move head to the start of the storage.
+     * e.g. when the DMA restarted from the beginning.
+     */
+    inline void restart() {
+        uint32_t next = (_head + _mask) & ~_mask;
+
+        _floor = next;
+        RING_BARRIER();
+        _head = next;
+    }
+
+public: // --> consumer.
+    /**
+     * get the contiguous readable span at tail.
+     * `len` receives the span length.
+     */
+    inline const uint8_t* front(uint32_t& len) {
+        uint32_t n = settle();
+        uint32_t pos = _tail & _mask;
+        uint32_t m = size() - pos;
+
+        RING_BARRIER();
+        len = n < m ? n : m;
+        return _buf + pos;
+    }
+
+    /* release `len` bytes read at tail. */
+    inline void consume(uint32_t len) {
+        RING_BARRIER();
+        _tail = _tail + len;
+    }
+
+    /**
+     * copy bytes at `offset` from tail without consuming, and returns copied bytes.
+     */
+    inline uint32_t peek(void* buf, uint32_t len, uint32_t offset = 0) {
+        uint32_t n = settle();
+        if (offset >= n) {
+            return 0;
+        }
+
+        if (len > n - offset) {
+            len = n - offset;
+        }
+
+        RING_BARRIER();
+        uint32_t pos = (_tail + offset) & _mask;
+        uint32_t m = size() - pos;
+
+        if (m >= len) {
+            memcpy(buf, _buf + pos, len);
+        }
+        else {
+            memcpy(buf, _buf + pos, m);
+            memcpy((uint8_t*) buf + m, _buf, len - m);
+        }
+
+        return len;
+    }
+
+    /**
+     * read bytes, and returns read bytes.
+     */
+    inline uint32_t read(void* buf, uint32_t len) {
+        len = peek(buf, len);
+        consume(len);
+        return len;
+    }
+
+    /* discard all readable bytes. */
+    inline void clear() {
+        settle();
+        _tail = _head;
+    }
+
+private:
+    /**
+     * read head and floor, and returns the consumer index past a new floor. (not applied yet)
+     * this does not modify anything, so the producer may call it too.
+     */
+    inline uint32_t start(uint32_t& head, uint32_t& floor) const {
+        uint32_t tail = _tail;
+
+        // --> the producer may restart between two reads.
+        do {
+            head = _head;
+            floor = _floor;
+        } while (head != _head);
+
+        // --> a new floor counts once, when it is between tail and head.
+        //   : a floor applied already comes between them again after 2^32 bytes.
+        if (floor != _seen && floor - tail <= head - tail) {
+            return floor;
+        }
+
+        return tail;
+    }
+
+    /* drop bytes lost by overrun or restart, and returns readable bytes. */
+    inline uint32_t settle() {
+        uint32_t head, floor;
+        uint32_t tail = start(head, floor);
+
+        // --> at the floor: the new one applied. (or the one applied already)
+        if (tail == floor) {
+            _dropped += tail - _tail;
+            _seen = floor;
+        }
+
+        if (head - tail > size()) {
+            _dropped += (head - tail) - size();
+            tail = head - size();
+        }
+
+        _tail = tail;
+        return head - tail;
+    }
+};
+
+/**
+ * Describes a ring with its own storage.
+ * e.g. ring_buf_t<1024> --> 1 KB ring.
+ */
+template<uint32_t rsize>
+class ring_buf_t : public ring_t {
+private:
+    static_assert(rsize > 0 && (rsize & (rsize - 1)) == 0, "rsize must be power of 2.");
+
+    uint8_t _storage[rsize];
+
+public:
+    ring_buf_t() : ring_t(_storage, rsize) { }
+};
+
+#endif // __RING_H__
@@ -1,5 +1,160 @@
 #include "spi.h"
 
+hspi_t spi_intr::_handles[SPI_MAX_HANDLES] = { nullptr, };
+volatile uint8_t spi_intr::_signals[SPI_MAX_HANDLES] = { 0, };
+
+int32_t spi_intr::slot(hspi_t hspi) {
+    for (int32_t i = 0; i < SPI_MAX_HANDLES; ++i) {
+        if (_handles[i] == hspi) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void spi_intr::signal(hspi_t hspi, uint8_t sig) {
+    int32_t n = slot(hspi);
+    if (n >= 0) {
+        _signals[n] = sig;
+    }
+}
+
+uint8_t spi_intr::signal(hspi_t hspi) {
+    int32_t n = slot(hspi);
+    return n >= 0 ? _signals[n] : SIG_NONE;
+}
+
+bool spi_intr::arm(hspi_t hspi) {
+    int32_t n = slot(hspi);
+
+    if (n < 0) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        // --> claim an empty slot.
+        if ((n = slot(nullptr)) >= 0) {
+            _handles[n] = hspi;
+        }
+
+        __set_PRIMASK(primask);
+    }
+
+    if (n < 0) {
+        return false;
+    }
+
+    _signals[n] = SIG_PENDING;
+    return true;
+}
+
+void spi_intr::proxy_cplt(hspi_t hspi) {
+    signal(hspi, SIG_DONE);
+
+    auto hook = spi_hook_t::root();
+    while(hook) {
+        auto next = hook->link();
+        if (hook->hooked() == hspi) {
+            hook->on_cplt();
+        }
+
+        hook = next;
+    }
+}
+
+void spi_intr::proxy_half(hspi_t hspi) {
+    auto hook = spi_hook_t::root();
+    while(hook) {
+        auto next = hook->link();
+        if (hook->hooked() == hspi) {
+            hook->on_half();
+        }
+
+        hook = next;
+    }
+}
+
+void spi_intr::proxy_error(hspi_t hspi) {
+    signal(hspi, SIG_ERROR);
+
+    auto hook = spi_hook_t::root();
+    while(hook) {
+        auto next = hook->link();
+        if (hook->hooked() == hspi) {
+            hook->on_error();
+        }
+
+        hook = next;
+    }
+}
+
+#if SPI_USE_CALLBACKS
+extern "C" {
+    void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+        spi_intr::proxy_cplt(hspi);
+    }
+
+    void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+        spi_intr::proxy_cplt(hspi);
+    }
+
+    void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+        spi_intr::proxy_cplt(hspi);
+    }
+
+    void HAL_SPI_RxHalfCpltCallback(SPI_HandleTypeDef *hspi) {
+        spi_intr::proxy_half(hspi);
+    }
+
+    void HAL_SPI_TxRxHalfCpltCallback(SPI_HandleTypeDef *hspi) {
+        spi_intr::proxy_half(hspi);
+    }
+
+    void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+        spi_intr::proxy_error(hspi);
+    }
+}
+#endif
+
+// --
+spi_hook_t* spi_hook_t::_root = nullptr;
+
+bool spi_hook_t::enable() {
+    auto temp = _root;
+    while(temp) {
+        if (temp == this) {
+            return false;
+        }
+
+        temp = temp->_link;
+    }
+
+    _link = _root;
+    _root = this;
+    return true;
+}
+
+bool spi_hook_t::disable() {
+    if (_root == this) {
+        _root = _link;
+        _link = nullptr;
+        return true;
+    }
+
+    auto temp = _root;
+    while(temp) {
+        if (temp->_link == this) {
+            temp->_link = _link;
+            _link = nullptr;
+            return true;
+        }
+
+        temp = temp->_link;
+    }
+
+    return false;
+}
+
 #if SPI_SUPPORT == 2
 void spi_t::stop() {
     SPI_NULL_GUARD_V();
@@ -9,15 +164,104 @@ void spi_t::stop() {
 }
 #endif 
 
-bool spi_t:: wait(uint32_t timeout) {
+bool spi_t::configure(uint32_t prescaler, uint32_t polarity, uint32_t phase) {
     SPI_NULL_GUARD();
 
+#if defined(SPI_CR1_BR)
+    const uint32_t mask = SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA;
+    const uint32_t bits = prescaler | polarity | phase;
+
+    if ((_spi->Instance->CR1 & mask) == bits) {
+        return true;
+    }
+
+    if (!ready()) {
+        return false;
+    }
+
+    // --> HAL enables SPE again on the next transfer.
+    __HAL_SPI_DISABLE(_spi);
+    MODIFY_REG(_spi->Instance->CR1, mask, bits);
+#else
+    if (_spi->Init.BaudRatePrescaler == prescaler &&
+        _spi->Init.CLKPolarity == polarity && _spi->Init.CLKPhase == phase)
+    {
+        return true;
+    }
+
+    if (!ready()) {
+        return false;
+    }
+#endif
+
+    _spi->Init.BaudRatePrescaler = prescaler;
+    _spi->Init.CLKPolarity = polarity;
+    _spi->Init.CLKPhase = phase;
+
+#if !defined(SPI_CR1_BR)
+    return HAL_SPI_Init(_spi) == HAL_OK;
+#else
+    return true;
+#endif
+}
+
+bool spi_t::finished(bool& error) {
+    // --> the signal is of the last armed transfer: a later one started without `arm`
+    //   : (e.g. HAL called directly) leaves it stale, so it counts only while HAL is ready.
+    switch (spi_intr::signal(_spi)) {
+        case spi_intr::SIG_PENDING:
+            // --> HAL is ready without callback: the start failed.
+            //   : (interrupts can not be observed half-done from thread mode)
+            return ready();
+
+        case spi_intr::SIG_ERROR:
+            if (!ready()) {
+                return false;
+            }
+
+            error = true;
+            return true;
+
+        case spi_intr::SIG_DONE:
+            return ready();
+
+        default:
+            break;
+    }
+
+    // --> not tracked: poll the HAL state.
+    return ready();
+}
+
+bool spi_t::wait(uint32_t timeout) {
+    SPI_NULL_GUARD();
+
+    bool error = false;
     uint32_t tick = HAL_GetTick();
+
     while(true) {
-        if (ready()) {
-            return true;
+#if SPI_WAIT_SLEEP
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        if (finished(error)) {
+            __set_PRIMASK(primask);
+            return !error;
         }
 
+        // --> sleep only in thread mode with interrupts enabled,
+        //   : the pending interrupt wakes WFI even while PRIMASK is set.
+        if (!primask && !__get_IPSR()) {
+            __WFI();
+        }
+
+        __set_PRIMASK(primask);
+#else
+        if (finished(error)) {
+            return !error;
+        }
+#endif
+
         uint32_t now = HAL_GetTick();
         if ((now - tick) >= timeout) {
             return false;
@@ -25,12 +269,102 @@ bool spi_t:: wait(uint32_t timeout) {
     }
 }
 
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+bool spi_t::wait_us(uint32_t timeout) {
+    SPI_NULL_GUARD();
+
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    bool error = false;
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles = timeout * (SystemCoreClock / 1000000u);
+
+    while(!finished(error)) {
+        if ((DWT->CYCCNT - start) >= cycles) {
+            return false;
+        }
+    }
+
+    return !error;
+}
+#endif
+
+#if SPI_USE_FAST
+bool spi_t::fast(const uint8_t* tx, uint8_t* rx, uint32_t len, uint32_t timeout) {
+    SPI_TypeDef* spi = _spi->Instance;
+
+    // --> 8-bit access: 16-bit access packs two frames on FIFO-ed SPIs.
+    volatile uint8_t* dr = (volatile uint8_t*) &spi->DR;
+
+    if (HAL_SPI_GetState(_spi) != HAL_SPI_STATE_READY) {
+        return false;
+    }
+
+    if (!(spi->CR1 & SPI_CR1_SPE)) {
+        __HAL_SPI_ENABLE(_spi);
+    }
+
+#ifdef SPI_CR2_FRXTH
+    // --> FIFO-ed SPIs: RXNE on a byte. HAL leaves it cleared after multi-byte transfers,
+    //   : then RXNE waits for two bytes and the loop below never finishes.
+    SET_BIT(spi->CR2, SPI_CR2_FRXTH);
+#endif
+
+    // --> drop stale bytes (RX FIFO is 4 bytes at most), and clear OVR. (read DR, then SR)
+    for (uint32_t i = 0; i < 4 && (spi->SR & SPI_SR_RXNE); ++i) {
+        (void) *dr;
+    }
+
+    (void) spi->SR;
+
+    uint32_t tick = HAL_GetTick();
+    for (uint32_t i = 0; i < len; ++i) {
+        while (!(spi->SR & SPI_SR_TXE)) {
+            if ((HAL_GetTick() - tick) >= timeout) {
+                return false;
+            }
+        }
+
+        *dr = tx ? tx[i] : 0xff;
+
+        while (!(spi->SR & SPI_SR_RXNE)) {
+            if ((HAL_GetTick() - tick) >= timeout) {
+                return false;
+            }
+        }
+
+        uint8_t value = *dr;
+        if (rx) {
+            rx[i] = value;
+        }
+    }
+
+    // --> the last clock edge, before CS goes high.
+    while (spi->SR & SPI_SR_BSY) {
+        if ((HAL_GetTick() - tick) >= timeout) {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
 #if SPI_SUPPORT != 0
 bool spi_t::read(void* buffer, uint32_t len, uint32_t timeout) {
     SPI_NULL_GUARD();
+#if SPI_USE_FAST
+    if (fastable(len)) {
+        return fast(nullptr, (uint8_t*) buffer, len, timeout);
+    }
+#endif
 #if SPI_SUPPORT == 2    // --> both.
     if (_dma) {
 #endif
+        spi_intr::arm(_spi);
         if (HAL_SPI_Receive_DMA(_spi, (uint8_t*) buffer, len) != HAL_OK) {
             return false;
         }
@@ -52,9 +386,15 @@ bool spi_t::read(void* buffer, uint32_t len, uint32_t timeout) {
 #if SPI_SUPPORT != 0
 bool spi_t::write(const void* buffer, uint32_t len, uint32_t timeout) {
     SPI_NULL_GUARD();
+#if SPI_USE_FAST
+    if (fastable(len)) {
+        return fast((const uint8_t*) buffer, nullptr, len, timeout);
+    }
+#endif
 #if SPI_SUPPORT == 2    // --> both.
     if (_dma) {
 #endif
+        spi_intr::arm(_spi);
         if (HAL_SPI_Transmit_DMA(_spi, (uint8_t*) buffer, len) != HAL_OK) {
             return false;
         }
@@ -76,9 +416,15 @@ bool spi_t::write(const void* buffer, uint32_t len, uint32_t timeout) {
 #if SPI_SUPPORT != 0
 bool spi_t::wread(const void* write, void* read, uint32_t len, uint32_t timeout) {
     SPI_NULL_GUARD();
+#if SPI_USE_FAST
+    if (fastable(len)) {
+        return fast((const uint8_t*) write, (uint8_t*) read, len, timeout);
+    }
+#endif
 #if SPI_SUPPORT == 2    // --> both.
     if (_dma) {
 #endif
+        spi_intr::arm(_spi);
         if (HAL_SPI_TransmitReceive_DMA(_spi,  (uint8_t*) write, (uint8_t*) read, len) != HAL_OK) {
             return false;
         }
@@ -101,6 +447,7 @@ bool spi_t::wread(const void* write, void* read, uint32_t len, uint32_t timeout)
 bool spi_t::read_n(void* buffer, uint32_t len) {
     SPI_NULL_GUARD();
     if (_dma) {
+        spi_intr::arm(_spi);
         return HAL_SPI_Receive_DMA(_spi, (uint8_t*) buffer, len) == HAL_OK;
     }
     
@@ -112,6 +459,7 @@ bool spi_t::read_n(void* buffer, uint32_t len) {
 bool spi_t::write_n(const void* buffer, uint32_t len) {
     SPI_NULL_GUARD();
     if (_dma) {
+        spi_intr::arm(_spi);
         return HAL_SPI_Transmit_DMA(_spi, (uint8_t*) buffer, len) == HAL_OK;
     }
 
@@ -123,6 +471,7 @@ bool spi_t::write_n(const void* buffer, uint32_t len) {
 bool spi_t::wread_n(const void* write, void* read, uint32_t len) {
     SPI_NULL_GUARD();
     if (_dma) {
+        spi_intr::arm(_spi);
         return HAL_SPI_TransmitReceive_DMA(_spi, (uint8_t*) write, (uint8_t*) read, len) == HAL_OK;
     }
 
@@ -10,6 +10,43 @@
 #define SPI_SUPPORT     2
 #endif
 
+// --> set 0 to define HAL_SPI_*Callback functions by yourself.
+//   : then, call `spi_intr::proxy_*` functions from them to use spi_hook_t.
+#ifndef SPI_USE_CALLBACKS
+#define SPI_USE_CALLBACKS   1
+#endif
+
+// --> max SPI handles to track DMA/IT completion signals.
+#ifndef SPI_MAX_HANDLES
+#define SPI_MAX_HANDLES     4
+#endif
+
+// --> set 0 to busy-wait instead of sleeping (WFI) in `spi_t::wait`.
+#ifndef SPI_WAIT_SLEEP
+#define SPI_WAIT_SLEEP      1
+#endif
+
+// --> transfers up to this length bypass HAL, and poll the registers directly.
+//   : set 0 to disable. (8-bit, full-duplex master only)
+#ifndef SPI_FAST_THRESHOLD
+#define SPI_FAST_THRESHOLD  8
+#endif
+
+#if SPI_FAST_THRESHOLD > 0 && defined(SPI_SR_TXE)
+#define SPI_USE_FAST        1
+#else
+#define SPI_USE_FAST        0
+#endif
+
+// --> set 1 to accept dma_buf_t. (see `../dmabuf/dmabuf.h`)
+#ifndef SPI_USE_DMABUF
+#define SPI_USE_DMABUF      0
+#endif
+
+#if SPI_USE_DMABUF
+#include "../dmabuf/dmabuf.h"
+#endif
+
 // --> to remove DMA fields permanently.
 #if SPI_SUPPORT == 2
 #define SPI_SUPPORT_FILTER(...) __VA_ARGS__
@@ -31,10 +68,56 @@
 // --> shortcut.
 using hspi_t = SPI_HandleTypeDef*;
 
+/**
+ * SPI interrupt dispatcher. (impl: spi.cpp)
+ * if SPI_USE_CALLBACKS is 0, call these from your own HAL_SPI_*Callback functions.
+ */
+class spi_intr {
+public:
+    /**
+     * completion signals per handle.
+     */
+    static constexpr uint8_t SIG_NONE = 0;      // --> not tracked.
+    static constexpr uint8_t SIG_PENDING = 1;
+    static constexpr uint8_t SIG_DONE = 2;
+    static constexpr uint8_t SIG_ERROR = 3;
+
+private:
+    static hspi_t _handles[SPI_MAX_HANDLES];
+    static volatile uint8_t _signals[SPI_MAX_HANDLES];
+
+    /* find the slot for the handle, or -1. */
+    static int32_t slot(hspi_t hspi);
+
+    /* set the signal of the handle if tracked. */
+    static void signal(hspi_t hspi, uint8_t sig);
+
+public:
+    /* proxy TX, RX and TX/RX complete interrupt call to hook instances. */
+    static void proxy_cplt(hspi_t hspi);
+
+    /* proxy RX and TX/RX half complete interrupt call to hook instances. (circular DMA) */
+    static void proxy_half(hspi_t hspi);
+
+    /* proxy ERROR interrupt call to hook instances. */
+    static void proxy_error(hspi_t hspi);
+
+    /**
+     * mark the handle as pending, right before starting DMA/IT transfer.
+     * returns false if no more slot to track the handle.
+     */
+    static bool arm(hspi_t hspi);
+
+    /* get the signal of the handle. */
+    static uint8_t signal(hspi_t hspi);
+};
+
 /**
  * Describes a SPI communication port.
  */
 class spi_t {
+    friend class spi_bench_t;
+
 private:
     hspi_t _spi;
 
@@ -82,6 +165,14 @@ public:
     inline bool use_dma() const { return (SPI_SUPPORT) == 1; }
 #endif
 
+    /**
+     * change the clock prescaler and mode of the SPI interface.
+     * e.g. configure(SPI_BAUDRATEPRESCALER_4, SPI_POLARITY_HIGH, SPI_PHASE_2EDGE).
+     * this touches the registers only when changed, and fails if not ready.
+     * on chips without BR field in CR1, this calls `HAL_SPI_Init`: do not call it from interrupt.
+     */
+    bool configure(uint32_t prescaler, uint32_t polarity, uint32_t phase);
+
     /**
      * test whether the SPI interface is ready or not.
      */
@@ -107,10 +198,38 @@ public:
 #endif 
     /**
      * wait for the SPI interface to be ready.
-     * returns true if its ready before timeout.
+     * returns true if its ready before timeout, false if timeout or error.
+     * this sleeps (WFI) until the completion interrupt, if SPI_WAIT_SLEEP is set.
      */
     bool wait(uint32_t timeout = infinite);
 
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    /**
+     * wait for the SPI interface to be ready, with microseconds timeout.
+     * this spins on DWT cycle counter, for short transfers.
+     */
+    bool wait_us(uint32_t timeout);
+#endif
+
+private:
+    /* test whether the last DMA/IT transfer finished or not. */
+    bool finished(bool& error);
+
+#if SPI_USE_FAST
+    /* test whether the transfer can take the register-level fast path or not. */
+    inline bool fastable(uint32_t len) const {
+        return len <= SPI_FAST_THRESHOLD &&
+            _spi->Init.Mode == SPI_MODE_MASTER &&
+            _spi->Init.Direction == SPI_DIRECTION_2LINES &&
+            _spi->Init.DataSize == SPI_DATASIZE_8BIT;
+    }
+
+    /* transfer bytes by polling TXE/RXNE. `tx` or `rx` can be null. */
+    bool fast(const uint8_t* tx, uint8_t* rx, uint32_t len, uint32_t timeout);
+#endif
+
+public:
+
     /**
      * read bytes from the target device.
      * returns true if success. note that, if timeout reached, this will stop the request.
@@ -120,6 +239,11 @@ public:
 #else
     inline bool read(void* buffer, uint32_t len, uint32_t timeout = infinite) {
         SPI_NULL_GUARD();
+#if SPI_USE_FAST
+        if (fastable(len)) {
+            return fast(nullptr, (uint8_t*) buffer, len, timeout);
+        }
+#endif
         return HAL_SPI_Receive(_spi, (uint8_t*) buffer, len, timeout) == HAL_OK;
     }
 #endif
@@ -133,6 +257,11 @@ public:
 #else
     inline bool write(const void* buffer, uint32_t len, uint32_t timeout = infinite) {
         SPI_NULL_GUARD();
+#if SPI_USE_FAST
+        if (fastable(len)) {
+            return fast((const uint8_t*) buffer, nullptr, len, timeout);
+        }
+#endif
         return HAL_SPI_Transmit(_spi, (uint8_t*) buffer, len, timeout) == HAL_OK;
     }
 #endif
@@ -146,6 +275,11 @@ public:
 #else
     inline bool wread(const void* write, void* read, uint32_t len, uint32_t timeout = infinite) {
         SPI_NULL_GUARD();
+#if SPI_USE_FAST
+        if (fastable(len)) {
+            return fast((const uint8_t*) write, (uint8_t*) read, len, timeout);
+        }
+#endif
         return HAL_SPI_TransmitReceive(_spi, (uint8_t*) write, (uint8_t*) read, len, timeout) == HAL_OK;
     }
 #endif
@@ -160,6 +294,7 @@ public:
 #elif SPI_SUPPORT == 1
     inline bool read_n(void* buffer, uint32_t len) {
         SPI_NULL_GUARD();
+        spi_intr::arm(_spi);
         return HAL_SPI_Receive_DMA(_spi, (uint8_t*) buffer, len) == HAL_OK;
     }
 #else
@@ -180,6 +315,7 @@ public:
 #elif SPI_SUPPORT == 1
     inline bool write_n(const void* buffer, uint32_t len) {
         SPI_NULL_GUARD();
+        spi_intr::arm(_spi);
         return HAL_SPI_Transmit_DMA(_spi, (uint8_t*) buffer, len) == HAL_OK;
     }
 #else
@@ -200,6 +336,7 @@ public:
 #elif SPI_SUPPORT == 1
     inline bool wread_n(const void* write, void* read, uint32_t len) {
         SPI_NULL_GUARD();
+        spi_intr::arm(_spi);
         return HAL_SPI_TransmitReceive_DMA(_spi, (uint8_t*) write, (uint8_t*) read, len) == HAL_OK;
     }
 #else
@@ -208,9 +345,188 @@ public:
         return HAL_SPI_TransmitReceive(_spi, (uint8_t*) write, (uint8_t*) read, len, infinite) == HAL_OK;
     }
 #endif
+
+#if SPI_USE_DMABUF
+    /**
+     * read `len` bytes into the DMA buffer, and set its length.
+     * the touched cache lines are invalidated if DMA used.
+     */
+    inline bool read(dma_buf_t& buf, uint32_t len, uint32_t timeout = infinite) {
+        if (len > buf.size()) {
+            return false;
+        }
+
+        if (use_dma()) {
+            buf.invalidate(len);
+        }
+
+        if (!read(buf.data(), len, timeout)) {
+            return false;
+        }
+
+        if (use_dma()) {
+            buf.invalidate(len);
+        }
+
+        buf.length(len);
+        return true;
+    }
+
+    /**
+     * write `length()` bytes of the DMA buffer.
+     * the touched cache lines are cleaned if DMA used.
+     */
+    inline bool write(const dma_buf_t& buf, uint32_t timeout = infinite) {
+        if (use_dma()) {
+            buf.clean();
+        }
+
+        return write(buf.data(), buf.length(), timeout);
+    }
+
+    /**
+     * write `length()` bytes of `tx`, and read the same length into `rx`.
+     */
+    inline bool wread(const dma_buf_t& tx, dma_buf_t& rx, uint32_t timeout = infinite) {
+        uint32_t len = tx.length();
+        if (len > rx.size()) {
+            return false;
+        }
+
+        if (use_dma()) {
+            tx.clean();
+            rx.invalidate(len);
+        }
+
+        if (!wread(tx.data(), rx.data(), len, timeout)) {
+            return false;
+        }
+
+        if (use_dma()) {
+            rx.invalidate(len);
+        }
+
+        rx.length(len);
+        return true;
+    }
+
+    /**
+     * read `len` bytes into the DMA buffer. (non-blocking)
+     * call `buf.invalidate()` after completion, before reading it.
+     */
+    inline bool read_n(dma_buf_t& buf, uint32_t len) {
+        if (len > buf.size()) {
+            return false;
+        }
+
+        if (use_dma()) {
+            buf.invalidate(len);
+        }
+
+        buf.length(len);
+        return read_n(buf.data(), len);
+    }
+
+    /**
+     * write `length()` bytes of the DMA buffer. (non-blocking)
+     */
+    inline bool write_n(const dma_buf_t& buf) {
+        if (use_dma()) {
+            buf.clean();
+        }
+
+        return write_n(buf.data(), buf.length());
+    }
+
+    /**
+     * write `length()` bytes of `tx`, and read the same length into `rx`. (non-blocking)
+     * call `rx.invalidate()` after completion, before reading it.
+     */
+    inline bool wread_n(const dma_buf_t& tx, dma_buf_t& rx) {
+        uint32_t len = tx.length();
+        if (len > rx.size()) {
+            return false;
+        }
+
+        if (use_dma()) {
+            tx.clean();
+            rx.invalidate(len);
+        }
+
+        rx.length(len);
+        return wread_n(tx.data(), rx.data(), len);
+    }
+#endif
 };
 
+/**
+ * Describes a receiver of SPI interrupt callbacks.
+ * warning: do not copy this instance anyway.
+ * because, the interrupt will not be passed to last initialized instance.
+ */
+class spi_hook_t {
+    friend class spi_intr;
+
+private:
+    hspi_t _hook;
+
+protected:
+    static spi_hook_t* _root;
+    spi_hook_t* _link;
+
+public:
+    /**
+     * initialize a spi_hook_t using its handle.
+     */
+    spi_hook_t(hspi_t spi) : _hook(spi), _link(nullptr) { }
+
+    /**
+     * de-initialize the spi_hook_t.
+     * this will unlink self from root.
+     */
+    virtual ~spi_hook_t() { disable(); }
+
+protected:
+    /* get the root instance. */
+    inline static spi_hook_t* root() { return _root; }
 
+    /* get the linked instance. */
+    inline spi_hook_t* link() const { return _link; }
 
+protected:
+    /**
+     * called when TX, RX or TX/RX `complete` interrupt occurred.
+     * do not do complex something in this method.
+     */
+    virtual void on_cplt() { }
+
+    /**
+     * called when RX or TX/RX `half complete` interrupt occurred.
+     */
+    virtual void on_half() { }
+
+    /**
+     * called when `error` interrupt occurred.
+     */
+    virtual void on_error() { }
+
+public:
+    /**
+     * get the hooked handle.
+     */
+    inline hspi_t hooked() const { return _hook; }
+
+    /**
+     * enable this instance.
+     * actually, link this instance to root.
+     */
+    virtual bool enable();
+
+    /**
+     * disable this instance.
+     * actually, unlink this instance from root.
+     */
+    virtual bool disable();
+};
 
 #endif // __SPI_H__
\ No newline at end of file
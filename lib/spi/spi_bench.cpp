@@ -0,0 +1,63 @@
+#include "spi_bench.h"
+
+#if SPI_USE_FAST && defined(DWT_CTRL_CYCCNTENA_Msk)
+
+constexpr uint16_t spi_bench_t::LENGTH[spi_bench_t::LENGTHS];
+
+void spi_bench_t::enable() {
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+bool spi_bench_t::run(spi_t& spi, result_t (&out)[LENGTHS], uint32_t runs) {
+    hspi_t hspi = spi.spi();
+
+    // --> the length is not limited here: `fast` takes any, `fastable` only caps the blocking calls.
+    if (!hspi || !spi.fastable(1) || !runs) {
+        return false;
+    }
+
+    uint8_t tx[16], rx[16];
+    for (uint32_t i = 0; i < sizeof(tx); ++i) {
+        tx[i] = 0xff;
+    }
+
+    enable();
+
+    for (uint8_t k = 0; k < LENGTHS; ++k) {
+        uint16_t len = LENGTH[k];
+        uint32_t fast = 0xffffffffu, hal = 0xffffffffu;
+
+        for (uint32_t i = 0; i < runs; ++i) {
+            uint32_t begin = DWT->CYCCNT;
+            if (!spi.fast(tx, rx, len, 10)) {
+                return false;
+            }
+
+            uint32_t cycles = DWT->CYCCNT - begin;
+            if (cycles < fast) {
+                fast = cycles;
+            }
+
+            begin = DWT->CYCCNT;
+            if (HAL_SPI_TransmitReceive(hspi, tx, rx, len, 10) != HAL_OK) {
+                return false;
+            }
+
+            cycles = DWT->CYCCNT - begin;
+            if (cycles < hal) {
+                hal = cycles;
+            }
+        }
+
+        out[k].len = len;
+        out[k].fast = fast;
+        out[k].hal = hal;
+    }
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __SPI_BENCH_H__
+#define __SPI_BENCH_H__
+
+// --> SPI wrapper.
+#include "spi.h"
+
+#if SPI_USE_FAST && defined(DWT_CTRL_CYCCNTENA_Msk)
+
+/**
+ * Measures the register-level fast path of `spi_t` against `HAL_SPI_TransmitReceive` on the target.
+ * both send the same bytes by full-duplex, and the DWT cycle counter times each transfer.
+ * --
+ * run this with the bus idle, and without a device selected. (or with one which ignores 0xff)
+ * interrupts stay enabled, so the fastest of the runs is taken as the cost of a transfer.
+ */
+class spi_bench_t {
+public:
+    /* transfer lengths to measure. */
+    static constexpr uint8_t LENGTHS = 3;
+    static constexpr uint16_t LENGTH[LENGTHS] = { 1, 4, 16 };
+
+    struct result_t {
+        uint16_t len;
+        uint32_t fast;      // --> cycles per transfer, `spi_t::fast`.
+        uint32_t hal;       // --> cycles per transfer, `HAL_SPI_TransmitReceive`.
+    };
+
+public:
+    /**
+     * measure each length `runs` times, and fill `out`.
+     * returns false if the interface can not take the fast path (see `SPI_FAST_THRESHOLD`), or a transfer failed.
+     */
+    static bool run(spi_t& spi, result_t (&out)[LENGTHS], uint32_t runs = 1000);
+
+private:
+    /* enable the DWT cycle counter. */
+    static void enable();
+};
+
+#endif
+#endif // __SPI_BENCH_H__
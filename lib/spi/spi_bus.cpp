@@ -0,0 +1,176 @@
+#include "spi_bus.h"
+
+bool spi_bus_t::before(const spi_xfer_t* a, const spi_xfer_t* b) {
+    uint8_t pa = a->dev ? a->dev->priority : 0xff;
+    uint8_t pb = b->dev ? b->dev->priority : 0xff;
+
+    if (pa != pb) {
+        return pa < pb;
+    }
+
+    return int32_t(a->deadline - b->deadline) < 0;
+}
+
+bool spi_bus_t::submit(spi_dev_t& dev, spi_xfer_t* xfer, uint32_t deadline) {
+    if (!xfer) {
+        return false;
+    }
+
+    if (deadline > SPI_BUS_NO_DEADLINE) {
+        deadline = SPI_BUS_NO_DEADLINE;
+    }
+
+    deadline += HAL_GetTick();
+    for (spi_xfer_t* temp = xfer; temp; temp = temp->next) {
+        temp->cs = dev.cs;
+        temp->dev = &dev;
+        temp->deadline = deadline;
+    }
+
+    return spi_queue_t::submit(xfer);
+}
+
+void spi_bus_t::push(spi_xfer_t* first, spi_xfer_t* last) {
+    spi_xfer_t*& head = pending();
+    (void) last;
+
+    // --> insert each frame in order. (stable for equal ones)
+    while (first) {
+        spi_xfer_t* tail = first;
+        while ((tail->flags & spi_xfer_t::HOLD) && tail->next) {
+            tail = tail->next;
+        }
+
+        spi_xfer_t* next = tail->next;
+        spi_xfer_t** slot = &head;
+
+        while (*slot) {
+            if (before(first, *slot)) {
+                break;
+            }
+
+            // --> skip the whole frame.
+            spi_xfer_t* temp = *slot;
+            while ((temp->flags & spi_xfer_t::HOLD) && temp->next) {
+                temp = temp->next;
+            }
+
+            slot = &temp->next;
+        }
+
+        tail->next = *slot;
+        *slot = first;
+        first = next;
+    }
+}
+
+spi_xfer_t* spi_bus_t::pick() {
+    spi_xfer_t*& head = pending();
+    if (!head) {
+        return nullptr;
+    }
+
+    uint32_t now = HAL_GetTick();
+    spi_xfer_t** slot = &head;
+    spi_xfer_t** found = &head;
+    bool late = false;
+
+    // --> the frame whose deadline passed goes first, regardless of priority.
+    while (*slot) {
+        spi_xfer_t* temp = *slot;
+        if (int32_t(now - temp->deadline) >= 0 &&
+            (!late || int32_t(temp->deadline - (*found)->deadline) < 0))
+        {
+            found = slot;
+            late = true;
+        }
+
+        while ((temp->flags & spi_xfer_t::HOLD) && temp->next) {
+            temp = temp->next;
+        }
+
+        slot = &temp->next;
+    }
+
+    spi_xfer_t* first = *found;
+    spi_xfer_t* last = first;
+
+    while ((last->flags & spi_xfer_t::HOLD) && last->next) {
+        last = last->next;
+    }
+
+    *found = last->next;
+    last->next = nullptr;
+    return first;
+}
+
+bool spi_bus_t::prepare(spi_xfer_t* xfer) {
+    spi_dev_t* dev = xfer->dev;
+    if (!dev || dev == _active) {
+        return true;
+    }
+
+#if !defined(SPI_CR1_BR)
+    // --> `HAL_SPI_Init` is not safe from interrupt.
+    if (__get_IPSR()) {
+        _active = nullptr;
+        return false;
+    }
+#endif
+
+    // --> running with the previous device's clock and mode would corrupt the frame.
+    if (!_spi.configure(dev->prescaler, dev->polarity, dev->phase)) {
+        _active = nullptr;
+        return false;
+    }
+
+    _active = dev;
+    return true;
+}
+
+bool spi_bus_t::transfer(spi_dev_t& dev, const void* tx, void* rx, uint16_t len,
+    uint32_t timeout, uint32_t deadline)
+{
+    spi_xfer_t xfer;
+
+    xfer.tx = tx;
+    xfer.rx = rx;
+    xfer.len = len;
+
+    if (!submit(dev, &xfer, deadline)) {
+        return false;
+    }
+
+    if (wait(&xfer, timeout)) {
+        return true;
+    }
+
+    cancel(&xfer);
+    return false;
+}
+
+bool spi_bus_t::command(spi_dev_t& dev, const void* cmd, uint16_t clen, const void* tx, void* rx, uint16_t len,
+    uint32_t timeout, uint32_t deadline)
+{
+    spi_xfer_t hdr, payload;
+
+    hdr.tx = cmd;
+    hdr.len = clen;
+    hdr.flags = spi_xfer_t::HOLD;
+    hdr.next = &payload;
+
+    payload.tx = tx;
+    payload.rx = rx;
+    payload.len = len;
+
+    if (!submit(dev, &hdr, deadline)) {
+        return false;
+    }
+
+    if (wait(&payload, timeout)) {
+        return hdr.state == spi_xfer_t::DONE;
+    }
+
+    cancel(&hdr);
+    return false;
+}
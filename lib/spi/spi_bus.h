@@ -0,0 +1,98 @@
+#ifndef __SPI_BUS_H__
+#define __SPI_BUS_H__
+
+// --> SPI transaction queue.
+#include "spi_queue.h"
+
+// --> ticks for `no deadline`, still comparable with wrap-around.
+static constexpr uint32_t SPI_BUS_NO_DEADLINE = 0x7fffffffu;
+
+/**
+ * Describes a device on the shared SPI bus.
+ */
+class spi_dev_t {
+public:
+    /* CS pin. */
+    pin_t cs;
+
+    /* SPI_BAUDRATEPRESCALER_*. */
+    uint32_t prescaler;
+
+    /* SPI_POLARITY_*. */
+    uint32_t polarity;
+
+    /* SPI_PHASE_*. */
+    uint32_t phase;
+
+    /* priority, 0 is the highest. */
+    uint8_t priority;
+
+public:
+    spi_dev_t(const pin_t& cs, uint32_t prescaler, uint32_t polarity, uint32_t phase, uint8_t priority = 0)
+        : cs(cs), prescaler(prescaler), polarity(polarity), phase(phase), priority(priority)
+    {
+    }
+};
+
+/**
+ * Describes a shared SPI bus.
+ * this serializes transactions of devices, and schedules pending frames by:
+ *  1. frames whose deadline passed, earliest first.
+ *  2. priority, and then deadline.
+ * the clock and mode are reconfigured only when the device changes,
+ * and the frame fails with ERROR if the bus can not be reconfigured.
+ * --
+ * warning: on chips without BR field in CR1, reconfiguring falls back to `HAL_SPI_Init`,
+ * which is not safe from interrupt, so a frame needing it fails when started from interrupt.
+ * there, frames of different settings must not be queued back to back:
+ * wait for each one (e.g. `transfer`, `command`) before submitting the next.
+ */
+class spi_bus_t : public spi_queue_t {
+private:
+    spi_t _spi;
+    spi_dev_t* _active;
+
+public:
+    /**
+     * initialize a new bus on the handle.
+     * call `enable()` to receive callbacks.
+     */
+    spi_bus_t(hspi_t spi, bool dma = false)
+        : spi_queue_t(spi, dma), _spi(spi, dma), _active(nullptr)
+    {
+    }
+
+public:
+    /* get the SPI interface. */
+    inline const spi_t& spi() const { return _spi; }
+
+    /**
+     * submit a descriptor chain for the device.
+     * `deadline` is in ticks from now, SPI_BUS_NO_DEADLINE (or greater) to have no deadline.
+     */
+    bool submit(spi_dev_t& dev, spi_xfer_t* xfer, uint32_t deadline = SPI_BUS_NO_DEADLINE);
+
+    /**
+     * transfer bytes with the device, and wait for it. (blocking)
+     * `tx` or `rx` can be null. `timeout` cancels the frame, and `deadline` schedules it. (see `submit`)
+     */
+    bool transfer(spi_dev_t& dev, const void* tx, void* rx, uint16_t len,
+        uint32_t timeout = spi_t::infinite, uint32_t deadline = SPI_BUS_NO_DEADLINE);
+
+    /**
+     * transmit a command header, and then transfer payload in one CS frame. (blocking)
+     */
+    bool command(spi_dev_t& dev, const void* cmd, uint16_t clen, const void* tx, void* rx, uint16_t len,
+        uint32_t timeout = spi_t::infinite, uint32_t deadline = SPI_BUS_NO_DEADLINE);
+
+protected:
+    virtual void push(spi_xfer_t* first, spi_xfer_t* last) override;
+    virtual spi_xfer_t* pick() override;
+    virtual bool prepare(spi_xfer_t* xfer) override;
+
+private:
+    /* test whether the frame `a` should run before `b` or not. */
+    static bool before(const spi_xfer_t* a, const spi_xfer_t* b);
+};
+
+#endif // __SPI_BUS_H__
@@ -0,0 +1,301 @@
+#include "spi_queue.h"
+
+/**
+ * Disables interrupts while the statement context is alive.
+ */
+class spi_queue_lock_t {
+private:
+    uint32_t _primask;
+
+public:
+    spi_queue_lock_t() : _primask(__get_PRIMASK()) { __disable_irq(); }
+    ~spi_queue_lock_t() { __set_PRIMASK(_primask); }
+};
+
+bool spi_queue_t::submit(spi_xfer_t* xfer) {
+    if (!xfer || !hooked()) {
+        return false;
+    }
+
+    spi_xfer_t* last = xfer;
+    while(true) {
+        if (!last->len || (!last->tx && !last->rx) ||
+            last->state == spi_xfer_t::PENDING || last->state == spi_xfer_t::ACTIVE)
+        {
+            return false;
+        }
+
+        if (!last->next) {
+            break;
+        }
+
+        last = last->next;
+    }
+
+    // --> HOLD on the last one would join the next submission.
+    last->flags &= ~spi_xfer_t::HOLD;
+
+    for (spi_xfer_t* temp = xfer; temp; temp = temp->next) {
+        temp->state = spi_xfer_t::PENDING;
+    }
+
+    spi_queue_lock_t _;
+    push(xfer, last);
+
+    if (!_cur) {
+        run(pick());
+    }
+
+    return true;
+}
+
+bool spi_queue_t::wait(const spi_xfer_t* xfer, uint32_t timeout) const {
+    uint32_t tick = HAL_GetTick();
+    while(!xfer->finished()) {
+        uint32_t now = HAL_GetTick();
+        if ((now - tick) >= timeout) {
+            return false;
+        }
+    }
+
+    return xfer->state == spi_xfer_t::DONE;
+}
+
+bool spi_queue_t::cancel(spi_xfer_t* xfer) {
+    spi_queue_lock_t _;
+
+    // --> running: abort it, and start the next frame.
+    for (spi_xfer_t* temp = xfer; temp; temp = temp->next) {
+        if (temp == _cur) {
+            HAL_SPI_Abort(hooked());
+            run(finish(_cur, spi_xfer_t::ERROR));
+            return true;
+        }
+
+        if (!(temp->flags & spi_xfer_t::HOLD)) {
+            break;
+        }
+    }
+
+    // --> pending: unlink the frame.
+    spi_xfer_t* prev = nullptr;
+    for (spi_xfer_t* temp = _head; temp; prev = temp, temp = temp->next) {
+        if (temp != xfer) {
+            continue;
+        }
+
+        spi_xfer_t* last = xfer;
+        while ((last->flags & spi_xfer_t::HOLD) && last->next) {
+            last = last->next;
+        }
+
+        if (prev) {
+            prev->next = last->next;
+        }
+        else {
+            _head = last->next;
+        }
+
+        if (_tail == last) {
+            _tail = prev;
+        }
+
+        last->next = nullptr;
+        while (xfer) {
+            spi_xfer_t* next = xfer->next;
+
+            xfer->state = spi_xfer_t::ERROR;
+            if (xfer->done) {
+                xfer->done(xfer);
+            }
+
+            xfer = next;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void spi_queue_t::abort() {
+    spi_queue_lock_t _;
+
+    spi_xfer_t* temp = _head;
+    _head = _tail = nullptr;
+
+    if (_cur) {
+        HAL_SPI_Abort(hooked());
+
+        // --> this fails the rest of the frame too.
+        //   : and starts the frames submitted from its callbacks, which `finish` picked.
+        run(finish(_cur, spi_xfer_t::ERROR));
+    }
+
+    while(temp) {
+        spi_xfer_t* next = temp->next;
+
+        temp->state = spi_xfer_t::ERROR;
+        if (temp->done) {
+            temp->done(temp);
+        }
+
+        temp = next;
+    }
+}
+
+void spi_queue_t::push(spi_xfer_t* first, spi_xfer_t* last) {
+    if (!_head) {
+        _head = first;
+    }
+    else {
+        _tail->next = first;
+    }
+
+    _tail = last;
+}
+
+spi_xfer_t* spi_queue_t::pick() {
+    spi_xfer_t* first = _head;
+    if (!first) {
+        return nullptr;
+    }
+
+    // --> take whole frame, and cut it from the pending list.
+    spi_xfer_t* last = first;
+    while ((last->flags & spi_xfer_t::HOLD) && last->next) {
+        last = last->next;
+    }
+
+    _head = last->next;
+    if (!_head) {
+        _tail = nullptr;
+    }
+
+    last->next = nullptr;
+    return first;
+}
+
+void spi_queue_t::on_cplt() {
+    if (!_cur) {
+        return;
+    }
+
+    run(finish(_cur, spi_xfer_t::DONE));
+}
+
+void spi_queue_t::on_error() {
+    if (!_cur) {
+        return;
+    }
+
+    run(finish(_cur, spi_xfer_t::ERROR));
+}
+
+void spi_queue_t::run(spi_xfer_t* xfer) {
+    while(xfer) {
+        if (!_held) {
+            // --> the bus can not be set up for it: fail the frame without CS.
+            if (!prepare(xfer)) {
+                xfer = finish(xfer, spi_xfer_t::ERROR);
+                continue;
+            }
+
+            xfer->cs.write(low);
+        }
+
+        _cur = xfer;
+        xfer->state = spi_xfer_t::ACTIVE;
+
+        if (start(xfer)) {
+            return;
+        }
+
+        xfer = finish(xfer, spi_xfer_t::ERROR);
+    }
+
+    _cur = nullptr;
+}
+
+spi_xfer_t* spi_queue_t::finish(spi_xfer_t* xfer, uint8_t state) {
+    spi_xfer_t* next = xfer->next;
+    bool hold = (xfer->flags & spi_xfer_t::HOLD) && next;
+
+    if (!hold || state == spi_xfer_t::ERROR) {
+        xfer->cs.write(high);
+        _held = false;
+    }
+    else {
+        _held = true;
+    }
+
+    xfer->state = state;
+    if (xfer->done) {
+        xfer->done(xfer);
+    }
+
+    if (state == spi_xfer_t::ERROR) {
+        // --> drop the rest of the frame.
+        while (hold) {
+            spi_xfer_t* temp = next;
+
+            next = temp->next;
+            hold = (temp->flags & spi_xfer_t::HOLD) && next;
+
+            temp->state = spi_xfer_t::ERROR;
+            if (temp->done) {
+                temp->done(temp);
+            }
+        }
+    }
+
+    if (hold) {
+        return next; // --> continue the frame with CS asserted.
+    }
+
+    return pick();
+}
+
+bool spi_queue_t::start(spi_xfer_t* xfer) {
+    hspi_t spi = hooked();
+    uint8_t* tx = (uint8_t*) xfer->tx;
+    uint8_t* rx = (uint8_t*) xfer->rx;
+    HAL_StatusTypeDef ret;
+
+    // --> reset the completion signal, for `spi_t::wait` on the same handle.
+    spi_intr::arm(spi);
+
+#if SPI_SUPPORT == 2
+    if (_dma) {
+#endif
+#if SPI_SUPPORT != 0
+        if (tx && rx) {
+            ret = HAL_SPI_TransmitReceive_DMA(spi, tx, rx, xfer->len);
+        }
+        else if (tx) {
+            ret = HAL_SPI_Transmit_DMA(spi, tx, xfer->len);
+        }
+        else {
+            ret = HAL_SPI_Receive_DMA(spi, rx, xfer->len);
+        }
+
+        return ret == HAL_OK;
+#endif
+#if SPI_SUPPORT == 2
+    }
+#endif
+
+#if SPI_SUPPORT != 1
+    if (tx && rx) {
+        ret = HAL_SPI_TransmitReceive_IT(spi, tx, rx, xfer->len);
+    }
+    else if (tx) {
+        ret = HAL_SPI_Transmit_IT(spi, tx, xfer->len);
+    }
+    else {
+        ret = HAL_SPI_Receive_IT(spi, rx, xfer->len);
+    }
+
+    return ret == HAL_OK;
+#endif
+}
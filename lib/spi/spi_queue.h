@@ -0,0 +1,172 @@
+#ifndef __SPI_QUEUE_H__
+#define __SPI_QUEUE_H__
+
+// --> SPI wrapper.
+#include "spi.h"
+
+// --> GPIO wrapper.
+#include "../pin/pin.h"
+
+// --> forward decl: spi_bus.h.
+class spi_dev_t;
+
+/**
+ * Describes a SPI transfer descriptor.
+ * the descriptor must be alive until it completes.
+ */
+struct spi_xfer_t {
+    /**
+     * flags.
+     * HOLD: keep CS asserted after this transfer, and continue the frame with `next`.
+     */
+    static constexpr uint8_t HOLD = 0x01;
+
+    /**
+     * states.
+     */
+    static constexpr uint8_t IDLE = 0;
+    static constexpr uint8_t PENDING = 1;
+    static constexpr uint8_t ACTIVE = 2;
+    static constexpr uint8_t DONE = 3;
+    static constexpr uint8_t ERROR = 4;
+
+    /* CS pin, `pin_t()` if not used. */
+    pin_t cs;
+
+    /* TX buffer, null to receive only. */
+    const void* tx;
+
+    /* RX buffer, null to transmit only. */
+    void* rx;
+
+    /* length in bytes. */
+    uint16_t len;
+
+    /* HOLD or 0. */
+    uint8_t flags;
+
+    /* IDLE, PENDING, ACTIVE, DONE or ERROR. */
+    volatile uint8_t state;
+
+    /* called from interrupt when the transfer completed or failed. */
+    void (*done)(spi_xfer_t* xfer);
+
+    /* user data. */
+    void* user;
+
+    /* (spi_bus_t) target device, and deadline tick. */
+    spi_dev_t* dev;
+    uint32_t deadline;
+
+    /**
+     * next descriptor in the chain.
+     * set this before `submit` to chain descriptors, and the queue uses it internally.
+     */
+    spi_xfer_t* next;
+
+    spi_xfer_t()
+        : tx(nullptr), rx(nullptr), len(0), flags(0), state(IDLE),
+          done(nullptr), user(nullptr), dev(nullptr), deadline(0), next(nullptr)
+    {
+    }
+
+    /* test whether the transfer completed (or failed) or not. */
+    inline bool finished() const { return state == DONE || state == ERROR; }
+};
+
+/**
+ * Describes a SPI transaction queue.
+ * descriptors are started back to back from the HAL complete callbacks,
+ * and CS is asserted/deasserted by the queue.
+ * --
+ * warning: do not use blocking calls of `spi_t` on the same handle while the queue is busy.
+ */
+class spi_queue_t : public spi_hook_t {
+private:
+    spi_xfer_t* _head;
+    spi_xfer_t* _tail;
+    spi_xfer_t* _cur;
+    bool _held;     // --> CS is kept asserted for the frame.
+
+#if SPI_SUPPORT == 2
+    bool _dma;
+#endif
+
+public:
+    /**
+     * initialize a new queue on the handle.
+     * call `enable()` to receive callbacks.
+     */
+    spi_queue_t(hspi_t spi, bool dma = false)
+        : spi_hook_t(spi), _head(nullptr), _tail(nullptr), _cur(nullptr), _held(false)
+          SPI_SUPPORT_FILTER(, _dma(dma))
+    {
+    }
+
+public:
+    /* test whether the queue is working or not. */
+    inline bool busy() const { return _cur != nullptr; }
+
+    /**
+     * submit a descriptor chain (linked by `next`), and start if idle.
+     * the chain is appended atomically, so HOLD-ed frames are never interleaved.
+     * this can be called from interrupt.
+     */
+    bool submit(spi_xfer_t* xfer);
+
+    /**
+     * wait for the descriptor to be finished.
+     * returns true if it completed successfully before timeout.
+     */
+    bool wait(const spi_xfer_t* xfer, uint32_t timeout = spi_t::infinite) const;
+
+    /**
+     * cancel the frame starting at `xfer`, pending or running.
+     * canceled descriptors are finished with ERROR.
+     */
+    bool cancel(spi_xfer_t* xfer);
+
+    /**
+     * abort all pending descriptors, and the active one.
+     * aborted descriptors are finished with ERROR.
+     */
+    void abort();
+
+protected:
+    virtual void on_cplt() override;
+    virtual void on_error() override;
+
+    /**
+     * pick the next chain head to start, and unlink it from the pending list.
+     * the default implementation is FIFO.
+     */
+    virtual spi_xfer_t* pick();
+
+    /**
+     * append the chain to the pending list.
+     * called with interrupts disabled.
+     */
+    virtual void push(spi_xfer_t* first, spi_xfer_t* last);
+
+    /**
+     * called right before a chain head is started, with CS deasserted.
+     * override this to reconfigure the bus per device, and return false to fail the frame.
+     * this is called from interrupt too, when a frame completes.
+     */
+    virtual bool prepare(spi_xfer_t* xfer) { (void) xfer; return true; }
+
+    /* get the pending list head. */
+    inline spi_xfer_t*& pending() { return _head; }
+
+private:
+    /* start descriptors until one is running. (or nothing left) */
+    void run(spi_xfer_t* xfer);
+
+    /* start the transfer on HAL, returns false if failed. */
+    bool start(spi_xfer_t* xfer);
+
+    /* finish the transfer, and returns the next descriptor in the frame. */
+    spi_xfer_t* finish(spi_xfer_t* xfer, uint8_t state);
+};
+
+#endif // __SPI_QUEUE_H__
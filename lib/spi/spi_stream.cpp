@@ -0,0 +1,114 @@
+#include "spi_stream.h"
+
+#if SPI_SUPPORT != 0
+bool spi_stream_t::start(void* buffer, uint16_t len, const void* tx) {
+    hspi_t spi = hooked();
+    if (!spi || !buffer || len < 2 || (len & 1) || _running) {
+        return false;
+    }
+
+    // --> one-shot DMA stops after the first round.
+    if (spi->hdmarx && spi->hdmarx->Init.Mode != DMA_CIRCULAR) {
+        return false;
+    }
+
+    _buf = (uint8_t*) buffer;
+    _half = len / 2;
+    _ready = _owned = NONE;
+    _lost = false;
+
+    // --> reset the completion signal, for `spi_t::wait` on the same handle.
+    spi_intr::arm(spi);
+
+    HAL_StatusTypeDef ret;
+    if (tx) {
+        ret = HAL_SPI_TransmitReceive_DMA(spi, (uint8_t*) tx, _buf, len);
+    }
+    else {
+        ret = HAL_SPI_Receive_DMA(spi, _buf, len);
+    }
+
+    _running = ret == HAL_OK;
+    return _running;
+}
+
+void spi_stream_t::stop() {
+    if (_running) {
+        HAL_SPI_DMAStop(hooked());
+        _running = false;
+    }
+}
+
+const uint8_t* spi_stream_t::acquire() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint8_t n = _ready;
+    if (n == NONE || _owned != NONE) {
+        __set_PRIMASK(primask);
+        return nullptr;
+    }
+
+    _ready = NONE;
+    _owned = n;
+    _lost = false;
+    __set_PRIMASK(primask);
+
+    uint8_t* ptr = _buf + n * _half;
+#if defined(__DCACHE_PRESENT) && __DCACHE_PRESENT
+    // --> DMA wrote behind the cache.
+    SCB_InvalidateDCache_by_Addr((void*) ptr, _half);
+#endif
+
+    return ptr;
+}
+
+bool spi_stream_t::release() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    bool lost = _lost;
+    _owned = NONE;
+    _lost = false;
+
+    __set_PRIMASK(primask);
+    return !lost;
+}
+
+void spi_stream_t::filled(uint8_t n) {
+    uint8_t other = n ^ 1;
+
+    // --> DMA starts writing the other half now.
+    if (_ready == other) {
+        _ready = NONE;
+        _overruns++;
+    }
+
+    if (_owned == other && !_lost) {
+        _lost = true;
+        _overruns++;
+    }
+
+    _ready = n;
+}
+
+void spi_stream_t::on_half() {
+    if (_running) {
+        filled(0);
+    }
+}
+
+void spi_stream_t::on_cplt() {
+    if (_running) {
+        filled(1);
+    }
+}
+
+void spi_stream_t::on_error() {
+    if (_running) {
+        _errors++;
+        _running = false;
+        HAL_SPI_DMAStop(hooked());
+    }
+}
+#endif
@@ -0,0 +1,90 @@
+#ifndef __SPI_STREAM_H__
+#define __SPI_STREAM_H__
+
+// --> SPI wrapper.
+#include "spi.h"
+
+#if SPI_SUPPORT != 0
+/**
+ * Describes a continuous SPI receiver using circular DMA.
+ * the buffer is split into two halves: while DMA fills one, the consumer reads the other.
+ * --
+ * the RX (and TX for TransmitReceive) DMA channel must be configured as circular mode.
+ * warning: do not use `spi_t` or `spi_queue_t` on the same handle while streaming.
+ */
+class spi_stream_t : public spi_hook_t {
+public:
+    /* no half. */
+    static constexpr uint8_t NONE = 0xff;
+
+private:
+    uint8_t* _buf;
+    uint16_t _half;             // --> bytes per half.
+    bool _running;
+
+    volatile uint8_t _ready;    // --> the half ready to consume, or NONE.
+    volatile uint8_t _owned;    // --> the half acquired by the consumer, or NONE.
+    volatile bool _lost;        // --> the acquired half was overwritten.
+    volatile uint32_t _overruns;
+    volatile uint32_t _errors;
+
+public:
+    /**
+     * initialize a new stream on the handle.
+     * call `enable()` to receive callbacks.
+     */
+    spi_stream_t(hspi_t spi)
+        : spi_hook_t(spi), _buf(nullptr), _half(0), _running(false),
+          _ready(NONE), _owned(NONE), _lost(false), _overruns(0), _errors(0)
+    {
+    }
+
+public:
+    /**
+     * start streaming into the buffer. `len` must be even.
+     * `tx` is the pattern to transmit repeatedly (same length), null to receive only.
+     */
+    bool start(void* buffer, uint16_t len, const void* tx = nullptr);
+
+    /* stop streaming. */
+    void stop();
+
+    /* test whether the stream is running or not. */
+    inline bool running() const { return _running; }
+
+    /* get bytes per half. */
+    inline uint16_t half() const { return _half; }
+
+    /**
+     * acquire the ready half without copying, or null if nothing ready.
+     * the half must be released by `release()` before acquiring the next one.
+     */
+    const uint8_t* acquire();
+
+    /**
+     * release the acquired half.
+     * returns false if DMA overwrote it while acquired, so its content is not reliable.
+     */
+    bool release();
+
+    /* get the count of halves which were overwritten before consumed. */
+    inline uint32_t overruns() const { return _overruns; }
+
+    /* get the count of errors. (the stream stops on error) */
+    inline uint32_t errors() const { return _errors; }
+
+    /* reset counters. */
+    inline void reset() { _overruns = _errors = 0; }
+
+protected:
+    virtual void on_half() override;
+    virtual void on_cplt() override;
+    virtual void on_error() override;
+
+private:
+    /* the half `n` has been filled, and DMA moves to the other one. */
+    void filled(uint8_t n);
+};
+#endif
+
+#endif // __SPI_STREAM_H__
@@ -2,20 +2,57 @@
 
 class uart_intr {
 public:
+    /**
+     * find the UART instance for the handle.
+     * the table resolves it in O(1), and the list is the fallback for slot collisions.
+     */
+    static uart_base_t* find(huart_t huart) {
+        auto uart = uart_base_t::_table[uart_base_t::slot(huart)];
+        if (uart && uart->handle() == huart) {
+            return uart;
+        }
+
+        uart = uart_base_t::root();
+        while(uart) {
+            if (uart->handle() == huart) {
+                return uart;
+            }
+
+            uart = uart->link();
+        }
+
+        return nullptr;
+    }
+
+    /* record the callback entry, if traced. */
+    static inline void enter(uart_base_t* uart) {
+#if UART_USE_TRACE
+        if (uart->_trace) {
+            uart->_trace->mark(uart_trace_t::ENTER);
+        }
+#else
+        (void) uart;
+#endif
+    }
+
+    /* record the callback exit, if traced. */
+    static inline void leave(uart_base_t* uart) {
+#if UART_USE_TRACE
+        if (uart->_trace) {
+            uart->_trace->mark(uart_trace_t::EXIT);
+        }
+#else
+        (void) uart;
+#endif
+    }
 
     /**
      * proxy ERROR interrupt call to UART instance.
      */
     static void proxy_error(huart_t huart) {
-        auto uart = uart_base_t::root();
-        while(uart) {
-            if (uart->handle() != huart) {
-                uart = uart->link();
-                continue;
-            } 
-
+        auto uart = find(huart);
+        if (uart) {
             uart->on_error();
-            break;
         }
     }
 
@@ -23,17 +60,37 @@ public:
      * proxy RX interrupt call to UART instance.
      */
     static void proxy_rx(huart_t huart) {
-        auto uart = uart_base_t::root();
-        while(uart) {
-            if (uart->handle() != huart) {
-                uart = uart->link();
-                continue;
-            } 
-
+        auto uart = find(huart);
+        if (uart) {
+            enter(uart);
             uart->on_recv();
-            break;
+            leave(uart);
+        }
+    }
+
+#if UART_USE_RING
+    /**
+     * proxy RX event (half, full, IDLE) call to UART instance.
+     */
+    static void proxy_event(huart_t huart, uint16_t pos) {
+        auto uart = find(huart);
+        if (uart) {
+            enter(uart);
+            uart->on_event(pos);
+            leave(uart);
         }
     }
+
+    /**
+     * proxy TX complete interrupt call to UART instance.
+     */
+    static void proxy_tx(huart_t huart) {
+        auto uart = find(huart);
+        if (uart) {
+            uart->on_sent();
+        }
+    }
+#endif
 };
 
 extern "C" {
@@ -44,13 +101,33 @@ extern "C" {
 	void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
 		uart_intr::proxy_error(huart);
 	}
+
+#if UART_USE_RING
+	void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+		uart_intr::proxy_event(huart, Size);
+	}
+
+	void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+		uart_intr::proxy_tx(huart);
+	}
+#endif
 }
 
 // --
 uart_base_t* uart_base_t::_root = nullptr;
+uart_base_t* uart_base_t::_table[UART_DISPATCH_SIZE] = { nullptr, };
 
 uart_base_t::uart_base_t(huart_t uart)
     : _uart(uart), _intr(0), _link(nullptr)
+#if UART_USE_DMABUF
+    , _rxbuf(nullptr)
+#endif
+#if UART_USE_RING
+    , _ring(nullptr), _rxpos(0), _overruns(0), _tx(nullptr), _txlen(0)
+#endif
+#if UART_USE_TRACE
+    , _trace(nullptr)
+#endif
 {
 }
 
@@ -72,6 +149,229 @@ bool uart_base_t::begin_intr(void* buf, uint32_t length) {
     return true;
 }
 
+#if UART_USE_DMABUF
+bool uart_base_t::begin_dma(dma_buf_t& buf, uint32_t length) {
+    if ((_intr & INTR_EN) || length > buf.size()) {
+        return false;
+    }
+
+    _intr |= INTR_EN;
+    _intr &= ~INTR_RX;
+    _intr &= ~INTR_ERR;
+
+    // --> drop the lines before DMA writes, not to be evicted over the data.
+    buf.invalidate(length);
+    buf.length(length);
+    _rxbuf = &buf;
+
+    if (HAL_UART_Receive_DMA(_uart, buf.data(), length) != HAL_OK) {
+        _rxbuf = nullptr;
+        _intr &= ~INTR_EN;
+        _intr |= INTR_ERR;
+        return false;
+    }
+
+    return true;
+}
+
+bool uart_base_t::write_n(const dma_buf_t& buf) {
+    buf.clean();
+    return HAL_UART_Transmit_DMA(_uart, (uint8_t*) buf.data(), buf.length()) == HAL_OK;
+}
+#endif
+
+#if UART_USE_RING
+bool uart_base_t::begin_ring(ring_t& ring) {
+    if ((_intr & INTR_EN) || _ring || ring.size() >= 0x10000u) {
+        return false;
+    }
+
+    // --> one-shot DMA stops when the storage is full.
+    if (_uart->hdmarx && _uart->hdmarx->Init.Mode != DMA_CIRCULAR) {
+        return false;
+    }
+
+    _intr |= INTR_EN;
+    _intr &= ~INTR_RX;
+    _intr &= ~INTR_ERR;
+
+    // --> DMA starts at the beginning of the storage.
+    ring.restart();
+    _rxpos = 0;
+    _ring = &ring;
+
+    if (HAL_UARTEx_ReceiveToIdle_DMA(_uart, ring.data(), ring.size()) != HAL_OK) {
+        _ring = nullptr;
+        _intr &= ~INTR_EN;
+        _intr |= INTR_ERR;
+        return false;
+    }
+
+    return true;
+}
+
+void uart_base_t::end_ring() {
+    if (_ring) {
+        HAL_UART_AbortReceive(_uart);
+
+        _ring = nullptr;
+        _intr &= ~INTR_EN;
+    }
+}
+
+void uart_base_t::on_event(uint16_t pos) {
+    if (!_ring) {
+        return;
+    }
+
+    // --> HAL reports the DMA position: half, full or where the line became IDLE.
+    uint32_t size = _ring->size();
+    uint32_t n = pos >= _rxpos ? pos - _rxpos : pos + size - _rxpos;
+
+    if (n) {
+        if (_ring->count() + n > size) {
+            _overruns++;
+        }
+
+        _ring->commit(n);
+        UART_TRACE(RX, n);
+    }
+
+    _rxpos = pos < size ? pos : 0;
+    _intr |= INTR_RX | INTR_IN;
+
+    on_ring_intr();
+    _intr &= ~INTR_IN;
+}
+
+bool uart_base_t::begin_tx(ring_t& ring) {
+    if (_tx) {
+        return false;
+    }
+
+    ring.clear();
+    _txlen = 0;
+    _tx = &ring;
+    return true;
+}
+
+uint32_t uart_base_t::write(const void* buf, uint32_t len) {
+    if (!_tx) {
+        return 0;
+    }
+
+    len = _tx->write(buf, len);
+    if (len) {
+        kick();
+    }
+
+    return len;
+}
+
+bool uart_base_t::write_all(const void* buf, uint32_t len, uint32_t timeout) {
+    const uint8_t* src = (const uint8_t*) buf;
+    uint32_t ticks = HAL_GetTick();
+
+    while (len) {
+        uint32_t n = write(src, len);
+
+        src += n;
+        len -= n;
+
+        if (!len) {
+            break;
+        }
+
+        uint32_t now = HAL_GetTick();
+        if (!_tx || (now - ticks) >= timeout) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool uart_base_t::flush(uint32_t timeout) {
+    uint32_t ticks = HAL_GetTick();
+
+    while (_tx && (!_tx->empty() || _txlen)) {
+        // --> retry if the start failed. (e.g. `write_b` was running)
+        kick();
+
+        uint32_t now = HAL_GetTick();
+        if ((now - ticks) >= timeout) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void uart_base_t::kick() {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (_tx && !_txlen) {
+        uint32_t len;
+        const uint8_t* span = _tx->front(len);
+
+        if (len > 0xffffu) {
+            len = 0xffffu;
+        }
+
+        if (len && HAL_UART_Transmit_DMA(_uart, (uint8_t*) span, len) == HAL_OK) {
+            _txlen = len;
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void uart_base_t::on_sent() {
+    if (!_tx || !_txlen) {
+        return;
+    }
+
+    _tx->consume(_txlen);
+    _txlen = 0;
+    kick();
+}
+
+void uart_base_t::on_tx_error() {
+    uint32_t sent = 0;
+
+    // --> the DMA counter keeps the remaining count after abort: the rest reached the UART.
+    //   : without it, resending the span would repeat the bytes already on the line.
+    if (_uart->hdmatx) {
+        uint32_t left = __HAL_DMA_GET_COUNTER(_uart->hdmatx);
+        sent = left < _txlen ? _txlen - left : 0;
+    }
+
+    _tx->consume(sent);
+    _txlen = 0;
+    kick();
+}
+
+void uart_base_t::on_ring_error() {
+    _intr |= INTR_ERR;
+
+    if (_uart->ErrorCode & HAL_UART_ERROR_ORE) {
+        _overruns++;
+    }
+
+    // --> HAL aborts the DMA reception on errors: restart from the beginning.
+    if (_uart->RxState == HAL_UART_STATE_READY) {
+        _ring->restart();
+        _rxpos = 0;
+
+        if (HAL_UARTEx_ReceiveToIdle_DMA(_uart, _ring->data(), _ring->size()) != HAL_OK) {
+            _ring = nullptr;
+            _intr &= ~INTR_EN;
+        }
+    }
+}
+#endif
+
 bool uart_base_t::enable() {
     auto temp = _root;
     while(temp) {
@@ -91,28 +391,50 @@ bool uart_base_t::enable() {
         _root = this;
     }
 
+    // --> the first one takes the slot, others are found by the list.
+    uint32_t n = slot(_uart);
+    if (!_table[n]) {
+        _table[n] = this;
+    }
+
     return true;
 }
 
 bool uart_base_t::disable() {
+    bool found = false;
+
     if (_root == this) {
         _root = _link;
         _link = nullptr;
-        return true;
+        found = true;
     }
 
-    auto temp = _root;
-    while(temp) {
-        if (temp->_link == this) {
-            temp->_link = _link;
-            _link = nullptr;
-            return true;
+    else {
+        auto temp = _root;
+        while(temp) {
+            if (temp->_link == this) {
+                temp->_link = _link;
+                _link = nullptr;
+                found = true;
+                break;
+            }
+
+            temp = temp->_link;
         }
+    }
 
-        temp = temp->_link;
+    // --> hand the slot over to the next one in the same slot.
+    uint32_t n = slot(_uart);
+    if (found && _table[n] == this) {
+        auto temp = _root;
+        while(temp && slot(temp->_uart) != n) {
+            temp = temp->_link;
+        }
+
+        _table[n] = temp;
     }
 
-    return false;
+    return found;
 }
 
 bool uart_base_t::wait(uint32_t timeout) const {
@@ -120,6 +442,21 @@ bool uart_base_t::wait(uint32_t timeout) const {
         return false;
     }
 
+#if UART_USE_RING
+    if (_ring) {
+        uint32_t ticks = HAL_GetTick();
+        while(_ring->empty()) {
+            uint32_t now = HAL_GetTick();
+            if (!_ring || (now - ticks) >= timeout) {
+                return false;
+            }
+        }
+
+        UART_TRACE(WAKE, 0);
+        return true;
+    }
+#endif
+
     if (intr_in()) {
         return true;
     }
@@ -127,6 +464,7 @@ bool uart_base_t::wait(uint32_t timeout) const {
     uint32_t ticks = HAL_GetTick();
     while(true) {
         if (intr_rx()) {
+            UART_TRACE(WAKE, 0);
             return true;
         }
 
@@ -140,3 +478,73 @@ bool uart_base_t::wait(uint32_t timeout) const {
         }
     }
 }
+
+bool uart_base_t::readable() const {
+#if UART_USE_RING
+    if (_ring) {
+        return !_ring->empty();
+    }
+#endif
+
+    return _intr & (INTR_RX | INTR_ERR);
+}
+
+/* collect the mask of readable ports. */
+static uint32_t uart_ready(uart_base_t* const* ports, uint8_t count) {
+    uint32_t mask = 0;
+
+    for (uint8_t i = 0; i < count && i < 32; ++i) {
+        if (ports[i] && ports[i]->readable()) {
+            mask |= 1u << i;
+#if UART_USE_TRACE
+            ports[i]->mark(uart_trace_t::WAKE);
+#endif
+        }
+    }
+
+    return mask;
+}
+
+uint32_t uart_select(uart_base_t* const* ports, uint8_t count, uint32_t timeout) {
+    uint32_t tick = HAL_GetTick();
+
+    while(true) {
+#if UART_WAIT_SLEEP
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        // --> test under PRIMASK: an interrupt after this wakes WFI, not lost.
+        uint32_t mask = uart_ready(ports, count);
+        if (mask) {
+            __set_PRIMASK(primask);
+            return mask;
+        }
+
+        // --> sleep only in thread mode with interrupts enabled.
+        if (!primask && !__get_IPSR()) {
+            __WFI();
+        }
+
+        __set_PRIMASK(primask);
+#else
+        uint32_t mask = uart_ready(ports, count);
+        if (mask) {
+            return mask;
+        }
+#endif
+
+        uint32_t now = HAL_GetTick();
+        if ((now - tick) >= timeout) {
+            return 0;
+        }
+    }
+}
+
+#if UART_USE_TRACE
+extern "C" void uart_trace_irq(UART_HandleTypeDef* huart) {
+    auto uart = uart_intr::find(huart);
+    if (uart) {
+        uart->mark(uart_trace_t::IRQ);
+    }
+}
+#endif
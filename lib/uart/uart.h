@@ -3,6 +3,48 @@
 
 #include "main.h"
 
+// --> set 1 to accept dma_buf_t. (see `../dmabuf/dmabuf.h`)
+#ifndef UART_USE_DMABUF
+#define UART_USE_DMABUF     0
+#endif
+
+#if UART_USE_DMABUF
+#include "../dmabuf/dmabuf.h"
+#endif
+
+// --> set 1 to use the RX ring with circular DMA. (see `../ring/ring.h`)
+//   : this requires HAL_UARTEx_ReceiveToIdle_DMA.
+#ifndef UART_USE_RING
+#define UART_USE_RING       0
+#endif
+
+#if UART_USE_RING
+#include "../ring/ring.h"
+#endif
+
+// --> set 1 to record DWT timestamps of RX events. (see `uart_trace.h`)
+#ifndef UART_USE_TRACE
+#define UART_USE_TRACE      0
+#endif
+
+#if UART_USE_TRACE
+#include "uart_trace.h"
+#define UART_TRACE(event, arg)  do { if (_trace) { _trace->mark(uart_trace_t::event, arg); } } while(0)
+#else
+#define UART_TRACE(event, arg)  do { } while(0)
+#endif
+
+// --> dispatch table size, indexed by the instance address bits [14:10].
+//   : e.g. USART1 (0x40011000) --> 4, USART2 (0x40004400) --> 17.
+#ifndef UART_DISPATCH_SIZE
+#define UART_DISPATCH_SIZE  32
+#endif
+
+// --> set 0 to busy-wait instead of sleeping (WFI) in `uart_select`.
+#ifndef UART_WAIT_SLEEP
+#define UART_WAIT_SLEEP     1
+#endif
+
 // --> shortcut.
 using huart_t = UART_HandleTypeDef*;
 
@@ -32,6 +74,41 @@ protected:
     static uart_base_t* _root;
     uart_base_t* _link;
 
+private:
+    static uart_base_t* _table[UART_DISPATCH_SIZE];
+
+    /* get the dispatch table slot of the handle. */
+    static inline uint32_t slot(huart_t uart) {
+        return (uint32_t(uintptr_t(uart->Instance)) >> 10) % UART_DISPATCH_SIZE;
+    }
+
+private:
+#if UART_USE_DMABUF
+    dma_buf_t* _rxbuf;  // --> DMA buffer being received by `begin_dma`.
+#endif
+
+#if UART_USE_RING
+    ring_t* _ring;      // --> RX ring being received by `begin_ring`.
+    uint16_t _rxpos;    // --> last DMA position in the ring storage.
+    volatile uint32_t _overruns;
+
+    ring_t* _tx;        // --> TX queue set by `begin_tx`.
+    volatile uint16_t _txlen;   // --> length of the span being sent by DMA.
+
+    /* restart the reception if HAL aborted it by error. */
+    void on_ring_error();
+
+    /* release the bytes sent before HAL aborted the TX DMA, and start the rest. */
+    void on_tx_error();
+
+    /* start DMA for the next contiguous span of the TX queue, if idle. */
+    void kick();
+#endif
+
+#if UART_USE_TRACE
+    uart_trace_t* _trace;
+#endif
+
 public:
     /**
      * initialize an uart_t using its handle.
@@ -56,6 +133,17 @@ protected:
      * called when `error` interrupt occurred.
      */
     virtual void on_error() {
+#if UART_USE_RING
+        // --> HAL aborted the TX DMA: send the rest of the span.
+        if (_tx && _txlen && _uart->gState == HAL_UART_STATE_READY) {
+            on_tx_error();
+        }
+
+        if (_ring) {
+            on_ring_error();
+            return;
+        }
+#endif
         _intr |= INTR_ERR | INTR_IN; 
 
         if (_intr & INTR_EN) {
@@ -73,6 +161,14 @@ protected:
      */
     virtual void on_recv() { 
         _intr |= INTR_RX | INTR_IN; 
+        UART_TRACE(RX, _uart->RxXferSize);
+
+#if UART_USE_DMABUF
+        if (_rxbuf) {
+            _rxbuf->invalidate();
+            _rxbuf = nullptr;
+        }
+#endif
 
         if (_intr & INTR_EN) {
             _intr &= ~INTR_EN;
@@ -90,12 +186,40 @@ protected:
      */
     bool begin_intr(void* buf, uint32_t length);
 
+#if UART_USE_DMABUF
+    /**
+     * begin the DMA based recv into the DMA buffer, and enable interrupt.
+     * the buffer must be alive until `on_read_intr`, and its cache lines are invalidated before that.
+     */
+    bool begin_dma(dma_buf_t& buf, uint32_t length);
+#endif
+
     /**
      * called from interrupt to renew buffer.
      * this must call `begin_intr` to receive more bytes.
      */
     virtual void on_read_intr() { }
 
+#if UART_USE_RING
+    /**
+     * called when HAL reports the RX event: half, full or IDLE line.
+     * this publishes received bytes to the ring, and calls `on_ring_intr`.
+     */
+    virtual void on_event(uint16_t pos);
+
+    /**
+     * called from interrupt when bytes arrived to the ring.
+     * e.g. wake the consumer task up.
+     */
+    virtual void on_ring_intr() { }
+
+    /**
+     * called when the TX DMA completed.
+     * this releases the sent span, and chains the next one.
+     */
+    virtual void on_sent();
+#endif
+
 public:
     /**
      * get the handle.
@@ -128,9 +252,91 @@ public:
 
     /**
      * wait for RX/ERR interrupt.
+     * if the RX ring is running, this waits for bytes in the ring.
      */
     bool wait(uint32_t timeout = 0xffffffffu) const;
 
+    /**
+     * test whether the port is readable or not, without waiting.
+     * RX/ERR interrupt triggered, or bytes in the RX ring.
+     */
+    bool readable() const;
+
+#if UART_USE_RING
+    /**
+     * begin the continuous recv into the ring, using circular DMA and IDLE line detection.
+     * the RX DMA channel must be configured as circular mode, and the ring size must be less than 64 KB. (HAL counts in 16 bits, so 32 KB at most)
+     */
+    bool begin_ring(ring_t& ring);
+
+    /* stop the continuous recv. */
+    void end_ring();
+
+    /* get the count of bytes in the RX ring. */
+    inline uint32_t available() const { return _ring ? _ring->count() : 0; }
+
+    /* read bytes from the RX ring, and returns read bytes. */
+    inline uint32_t read(void* buf, uint32_t len) {
+        uint32_t n = _ring ? _ring->read(buf, len) : 0;
+        if (n) {
+            UART_TRACE(WAKE, n);
+        }
+
+        return n;
+    }
+
+    /* get the count of overruns. (UART overrun error, or the ring was full) */
+    inline uint32_t overruns() const { return _overruns; }
+
+    /**
+     * use the ring as TX queue, then `write` appends to it and returns immediately.
+     * the TX DMA channel must be configured as normal mode.
+     */
+    bool begin_tx(ring_t& ring);
+
+    /**
+     * append bytes to the TX queue, and returns appended bytes. (non-blocking)
+     * this appends only what fits, so compare the result for back-pressure.
+     * note that, call this from one context only. (thread or interrupt)
+     */
+    uint32_t write(const void* buf, uint32_t len);
+
+    /**
+     * append all bytes to the TX queue, waiting for space up to timeout.
+     * returns false if timeout reached.
+     */
+    bool write_all(const void* buf, uint32_t len, uint32_t timeout = 0xffffffffu);
+
+    /* get the count of bytes that can be appended without waiting. */
+    inline uint32_t writable() const { return _tx ? _tx->space() : 0; }
+
+    /* get the count of bytes not sent yet. */
+    inline uint32_t pending() const { return _tx ? _tx->count() : 0; }
+
+    /**
+     * wait for all queued bytes to be sent.
+     * returns false if timeout reached.
+     */
+    bool flush(uint32_t timeout = 0xffffffffu);
+#endif
+
+#if UART_USE_TRACE
+    /**
+     * set the trace to record RX events of this port. null to detach.
+     */
+    inline void trace(uart_trace_t* trace) { _trace = trace; }
+
+    /* get the trace. */
+    inline uart_trace_t* trace() const { return _trace; }
+
+    /* record an user event. (e.g. the response queued) */
+    inline void mark(uint8_t event, uint16_t arg = 0) {
+        if (_trace) {
+            _trace->mark(event, arg);
+        }
+    }
+#endif
+
     /**
      * write the buffer through UART port.
      * returns false if timeout reached or error.
@@ -139,7 +345,29 @@ public:
         return HAL_UART_Transmit(_uart, (uint8_t*) buf, length, timeout);
     }
 
+#if UART_USE_DMABUF
+    /**
+     * write `length()` bytes of the DMA buffer using DMA. (non-blocking)
+     * the buffer must be alive until the transmission completes.
+     */
+    bool write_n(const dma_buf_t& buf);
+#endif
+
 };
 
+/**
+ * wait until any of the ports is readable, and returns the mask of readable ports. (bit i --> ports[i])
+ * this sleeps (WFI) between interrupts if UART_WAIT_SLEEP is set, and returns 0 if timeout reached.
+ * null entries are skipped, and up to 32 ports.
+ */
+uint32_t uart_select(uart_base_t* const* ports, uint8_t count, uint32_t timeout = 0xffffffffu);
+
+#if UART_USE_TRACE
+/**
+ * record the USART IRQ entry of the handle. (optional)
+ * call this first in `USARTx_IRQHandler`, before `HAL_UART_IRQHandler`.
+ */
+extern "C" void uart_trace_irq(UART_HandleTypeDef* huart);
+#endif
 
 #endif // __UART_H__
@@ -0,0 +1,64 @@
+#include "uart.h"
+
+#if UART_USE_TRACE
+
+void uart_trace_t::start() {
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    _on = true;
+}
+
+bool uart_trace_t::stats(uint8_t from, uint8_t to, stats_t& out) {
+    uint32_t total = count();
+    uint32_t n = 0;
+
+    bool pending = false;
+    uint32_t since = 0;
+
+    for (uint32_t i = 0; i < total; ++i) {
+        const record_t& rec = at(i);
+
+        if (rec.event == from && !pending) {
+            pending = true;
+            since = rec.cycles;
+        }
+
+        else if (rec.event == to && pending) {
+            // --> unsigned difference survives the counter wrap.
+            _work[n++] = rec.cycles - since;
+            pending = false;
+        }
+    }
+
+    out.count = n;
+    if (!n) {
+        out.min = out.p50 = out.p90 = out.p99 = out.max = 0;
+        return false;
+    }
+
+    // --> shell sort: no heap, and fast enough for a few thousands.
+    for (uint32_t gap = n / 2; gap > 0; gap /= 2) {
+        for (uint32_t i = gap; i < n; ++i) {
+            uint32_t v = _work[i];
+            uint32_t j = i;
+
+            while (j >= gap && _work[j - gap] > v) {
+                _work[j] = _work[j - gap];
+                j -= gap;
+            }
+
+            _work[j] = v;
+        }
+    }
+
+    out.min = _work[0];
+    out.p50 = _work[(n - 1) * 50 / 100];
+    out.p90 = _work[(n - 1) * 90 / 100];
+    out.p99 = _work[(n - 1) * 99 / 100];
+    out.max = _work[n - 1];
+    return true;
+}
+#endif
@@ -0,0 +1,123 @@
+#ifndef __UART_TRACE_H__
+#define __UART_TRACE_H__
+
+#include "main.h"
+
+/**
+ * Describes a trace of UART RX latency, using the DWT cycle counter. (Cortex-M3 or later)
+ * records are kept in a ring on external storage, and the oldest are overwritten.
+ * the storage is provided by `uart_trace_buf_t<count>`.
+ */
+class uart_trace_t {
+public:
+    /* events. */
+    static constexpr uint8_t IRQ = 0;       // --> USART IRQ entry. (`uart_trace_irq`, optional)
+    static constexpr uint8_t ENTER = 1;     // --> HAL callback entry.
+    static constexpr uint8_t RX = 2;        // --> bytes delivered, arg: count.
+    static constexpr uint8_t EXIT = 3;      // --> HAL callback exit.
+    static constexpr uint8_t WAKE = 4;      // --> the consumer got bytes. (`wait`, `read`, `uart_select`)
+    static constexpr uint8_t USER = 8;      // --> user events: USER + n, by `mark`.
+
+    struct record_t {
+        uint32_t cycles;
+        uint8_t event;
+        uint8_t reserved;
+        uint16_t arg;
+    };
+
+    /* latency statistics, in cycles. */
+    struct stats_t {
+        uint32_t count;
+        uint32_t min;
+        uint32_t p50;
+        uint32_t p90;
+        uint32_t p99;
+        uint32_t max;
+    };
+
+private:
+    record_t* _buf;
+    uint32_t* _work;
+    uint32_t _mask;
+    volatile uint32_t _head;
+    volatile bool _on;
+
+public:
+    /**
+     * initialize a new trace on the storage.
+     * `count` must be power of 2, and `work` must have `count` entries.
+     */
+    uart_trace_t(record_t* buf, uint32_t* work, uint32_t count)
+        : _buf(buf), _work(work), _mask(count - 1), _head(0), _on(false)
+    {
+    }
+
+public:
+    /* start recording, and enable the DWT cycle counter. */
+    void start();
+
+    /* stop recording. call this before `stats`. */
+    inline void stop() { _on = false; }
+
+    /* discard all records. */
+    inline void clear() { _head = 0; }
+
+    /* get the count of records kept. */
+    inline uint32_t count() const { return _head < _mask + 1 ? _head : _mask + 1; }
+
+    /* get the record, 0 is the oldest one. */
+    inline const record_t& at(uint32_t i) const {
+        uint32_t base = _head - count();
+        return _buf[(base + i) & _mask];
+    }
+
+    /**
+     * record an event. safe to call from interrupt.
+     */
+    inline void mark(uint8_t event, uint16_t arg = 0) {
+        if (!_on) {
+            return;
+        }
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        record_t& rec = _buf[_head & _mask];
+        rec.cycles = DWT->CYCCNT;
+        rec.event = event;
+        rec.arg = arg;
+        _head = _head + 1;
+
+        __set_PRIMASK(primask);
+    }
+
+    /**
+     * compute the latency from `from` to the next `to` event.
+     * each `to` is paired with the earliest `from` not paired yet, and the later ones are ignored.
+     * e.g. stats(RX, WAKE, s) --> from the delivery to the consumer.
+     */
+    bool stats(uint8_t from, uint8_t to, stats_t& out);
+
+    /* convert cycles to microseconds. */
+    static inline uint32_t us(uint32_t cycles) {
+        return uint32_t((uint64_t(cycles) * 1000000u) / SystemCoreClock);
+    }
+};
+
+/**
+ * Describes a trace with its own storage.
+ * e.g. uart_trace_buf_t<256> --> 256 records, 3 KB.
+ */
+template<uint32_t records>
+class uart_trace_buf_t : public uart_trace_t {
+private:
+    static_assert(records > 0 && (records & (records - 1)) == 0, "records must be power of 2.");
+
+    record_t _storage[records];
+    uint32_t _deltas[records];
+
+public:
+    uart_trace_buf_t() : uart_trace_t(_storage, _deltas, records) { }
+};
+
+#endif // __UART_TRACE_H__
@@ -1,4 +1,5 @@
 #include "w25qxx.h"
+#include <string.h>
 
 #ifdef W250XX_EXPLICIT_BLK
 #define W25QXX_INIT_GUARD(ret) \
@@ -116,7 +117,169 @@ bool w25qxx_t::recognize() {
     return true;
 }
 
+// --> prescalers, from the slowest to the fastest.
+static const uint32_t W25QXX_PRESCALERS[] = {
+    SPI_BAUDRATEPRESCALER_256, SPI_BAUDRATEPRESCALER_128,
+    SPI_BAUDRATEPRESCALER_64, SPI_BAUDRATEPRESCALER_32,
+    SPI_BAUDRATEPRESCALER_16, SPI_BAUDRATEPRESCALER_8,
+    SPI_BAUDRATEPRESCALER_4, SPI_BAUDRATEPRESCALER_2
+};
+
+// --> bytes to verify on each step, and rounds per step.
+#ifndef W25QXX_CALIB_LEN
+#define W25QXX_CALIB_LEN    64
+#endif
+
+#ifndef W25QXX_CALIB_ROUNDS
+#define W25QXX_CALIB_ROUNDS 4
+#endif
+
+uint32_t w25qxx_t::read_id() {
+    uint8_t tx[4] = { 0x9f, 0xff, 0xff, 0xff };
+    uint8_t rx[4];
+
+    select();
+    if (!_spi.wread(tx, rx, 4, 100)) {
+        deselect();
+        return 0;
+    }
+
+    deselect();
+    return (uint32_t(rx[1]) << 16) | (uint32_t(rx[2]) << 8) | rx[3];
+}
+
+bool w25qxx_t::verify(uint32_t id, uint32_t addr, const uint8_t* ref, uint32_t len) {
+    uint8_t temp[W25QXX_CALIB_LEN];
+
+    for (uint32_t i = 0; i < W25QXX_CALIB_ROUNDS; ++i) {
+        if (read_id() != id) {
+            return false;
+        }
+
+        if (read_raw(addr, temp, len, 100) != len || memcmp(temp, ref, len)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool w25qxx_t::calibrate(uint32_t addr, uint8_t margin) {
+    constexpr uint32_t count = sizeof(W25QXX_PRESCALERS) / sizeof(W25QXX_PRESCALERS[0]);
+    uint8_t ref[W25QXX_CALIB_LEN];
+
+    if (!_spi || !recognize() || !wait_busy(1000)) {
+        return false;
+    }
+
+    uint32_t len = max_addr() - addr;
+    if (addr >= max_addr()) {
+        return false;
+    }
+
+    if (len > sizeof(ref)) {
+        len = sizeof(ref);
+    }
+
+    // --> `verify` reconfigures the shared bus: put it back for the other devices on failure.
+    hspi_t spi = _spi.spi();
+    uint32_t bus = spi->Init.BaudRatePrescaler;
+
+    // --> baseline at the slowest clock.
+    uint32_t prev = _clk;
+    _clk = W25QXX_PRESCALERS[0];
+
+    uint32_t id = read_id();
+    if (!id || id == 0xffffffu || read_raw(addr, ref, len, 100) != len) {
+        _clk = prev;
+        _spi.configure(bus, spi->Init.CLKPolarity, spi->Init.CLKPhase);
+        return false;
+    }
+
+    // --> step up until the first failure.
+    uint32_t passed = 0;
+    while (passed < count) {
+        _clk = W25QXX_PRESCALERS[passed];
+        if (!verify(id, addr, ref, len)) {
+            break;
+        }
+
+        passed++;
+    }
+
+    // --> unstable even at the slowest clock.
+    if (!passed) {
+        _clk = prev;
+        _spi.configure(bus, spi->Init.CLKPolarity, spi->Init.CLKPhase);
+        return false;
+    }
+
+    uint32_t fastest = passed - 1;
+    _clk = W25QXX_PRESCALERS[fastest > margin ? fastest - margin : 0];
+    apply_clock();
+    return true;
+}
+
 uint32_t w25qxx_t::read(uint32_t addr, void* buf, uint32_t len, uint32_t timeout) {
+#if W25QXX_USE_CACHE
+    if (_cache) {
+        return read_cached(addr, buf, len, timeout);
+    }
+#endif
+    return read_raw(addr, buf, len, timeout);
+}
+
+#if W25QXX_USE_CACHE
+uint32_t w25qxx_t::read_cached(uint32_t addr, void* buf, uint32_t len, uint32_t timeout) {
+    W25QXX_INIT_GUARD(0);
+    uint32_t max = max_addr();
+    if (addr >= max) {
+        return 0;
+    }
+
+    if (addr + len > max) {
+        len = max - addr;
+    }
+
+    // --> bulk read: do not flush the whole cache out.
+    if (len >= _cache->size()) {
+        return read_raw(addr, buf, len, timeout);
+    }
+
+    const uint32_t line = _cache->line();
+    uint8_t* cursor = (uint8_t*) buf;
+
+    while (len > 0) {
+        uint32_t tag = addr / line;
+        uint32_t offset = addr % line;
+        uint32_t slice = line - offset;
+
+        if (slice > len) {
+            slice = len;
+        }
+
+        uint8_t* data = _cache->lookup(tag);
+        if (!data) {
+            data = _cache->assign(tag);
+
+            if (read_raw(tag * line, data, line, timeout) != line) {
+                _cache->invalidate(tag * line, line);
+                break;
+            }
+        }
+
+        memcpy(cursor, data + offset, slice);
+
+        addr += slice;
+        len -= slice;
+        cursor += slice;
+    }
+
+    return uint32_t(cursor - (uint8_t*) buf);
+}
+#endif
+
+uint32_t w25qxx_t::read_raw(uint32_t addr, void* buf, uint32_t len, uint32_t timeout) {
     W25QXX_INIT_GUARD(0);
     uint32_t max = max_addr();
     if (addr >= max) {
@@ -184,13 +347,15 @@ uint32_t w25qxx_t::write_pi(uint32_t page, uint32_t offset, const void* buf, uin
         return 0;
     }
 
-    uint32_t addr = page * PAGE_SIZE;
+    uint32_t addr = page * PAGE_SIZE + offset;
     uint32_t max = PAGE_SIZE - offset;
 
     if (len > max) {
         len = max;
     }
 
+    invalidate(addr, len);
+
     if (enwrite() == false) {
         return 0;
     }
@@ -237,13 +402,16 @@ uint32_t w25qxx_t::write_pi(uint32_t page, uint32_t offset, const void* buf, uin
     if (ret) {
         ret = _spi.write(buf, len);
     }
-    
+
+    // --> the chip programs the page when CS goes high: polling the status before that
+    //   : clocks the status command into the page, and wraps over its first bytes.
+    deselect();
+
     if (ret) {
         wait_busy();
     }
 
     diswrite();
-    deselect();
     return ret ? len : 0;
 }
 
@@ -275,6 +443,7 @@ uint32_t w25qxx_t::write(uint32_t addr, const void* buf, uint32_t len, uint32_t
 
 bool w25qxx_t::erase() {
     W25QXX_INIT_GUARD(0);
+    invalidate(0, max_addr());
     if (enwrite() == false) {
         return false;
     }
@@ -302,8 +471,10 @@ bool w25qxx_t::erase_sector(uint32_t sector) {
         return false;
     }
 
-    select();
     uint32_t addr = sector * SECTOR_SIZE;
+    invalidate(addr, SECTOR_SIZE);
+
+    select();
 
     bool ret = false;
 #if W250XX_EXPLICIT_BLK >= 512
@@ -361,8 +532,10 @@ bool w25qxx_t::erase_block(uint32_t block) {
         return false;
     }
 
-    select();
     uint32_t addr = block * BLOCK_SIZE;
+    invalidate(addr, BLOCK_SIZE);
+
+    select();
 	
     bool ret = false;
 #if W250XX_EXPLICIT_BLK >= 512
@@ -12,6 +12,18 @@
 #define W25QXX_ENSZ_0x20    0
 #endif
 
+// --> set 1 to enable the read cache. (see `w25qxx_cache.h`)
+#ifndef W25QXX_USE_CACHE
+#define W25QXX_USE_CACHE    0
+#endif
+
+#if W25QXX_USE_CACHE
+#include "w25qxx_cache.h"
+#define W25QXX_CACHE_FILTER(...) __VA_ARGS__
+#else
+#define W25QXX_CACHE_FILTER(...)
+#endif
+
 // --> set this to use explicit implementation for specified size.
 // #define W25QXX_EXPLICIT_MBIT  32  // --> 32 Mbit.
 
@@ -49,21 +61,39 @@ private:
     uint32_t _block; // --> block size.
 #endif
 
+#if W25QXX_USE_CACHE
+    w25qxx_cache_ctl_t* _cache;
+#endif
+
+    uint32_t _clk;   // --> SPI_BAUDRATEPRESCALER_*, or infinite to keep the handle's.
+
 public:
     /**
      * initialize a w25qxx_t using SPI and CS pin.
      */
     w25qxx_t(const spi_t& spi, const pin_t& cs = pin_t())
         : _spi(spi), _cs(cs), W250XX_SWITCH_INIT(_block(0), _init(0))
+          W25QXX_CACHE_FILTER(, _cache(nullptr)), _clk(0xffffffffu)
     {   
     }
 
 protected:
     /* chip select. */
-    virtual void select() const { _cs.write(low); pin_t::delay(); }
+    virtual void select() const { apply_clock(); _cs.write(low); pin_t::delay(); }
 
     /* chip deselect. */
     virtual void deselect() const { _cs.write(high); pin_t::delay(); }
+
+    /**
+     * apply the calibrated clock to the SPI interface, if set.
+     * call this first when overriding `select()`.
+     */
+    inline void apply_clock() const {
+        hspi_t spi = _spi.spi();
+        if (_clk != 0xffffffffu && spi) {
+            _spi.configure(_clk, spi->Init.CLKPolarity, spi->Init.CLKPhase);
+        }
+    }
     
 public:
     /* test whether the chip is busy or not. */
@@ -113,11 +143,87 @@ public:
      */
     bool recognize();
 
+    /**
+     * calibrate the SPI clock of this chip, and returns true if success.
+     * this steps the prescaler down from the slowest one, verifies JEDEC ID and
+     * the reference bytes at `addr` (read at the slowest clock) on each step,
+     * and then locks in the fastest reliable one minus `margin` steps.
+     * note that, `addr` should point non-blank data. (e.g. a table, not erased area)
+     */
+    bool calibrate(uint32_t addr = 0, uint8_t margin = 1);
+
+    /**
+     * get the calibrated clock. (SPI_BAUDRATEPRESCALER_*)
+     * returns 0xffffffff if not calibrated, which means the handle's clock is used.
+     */
+    inline uint32_t clock() const { return _clk; }
+
+    /**
+     * set the clock explicitly, e.g. restore the stored calibration result.
+     * set 0xffffffff to use the handle's clock.
+     */
+    inline void clock(uint32_t prescaler) { _clk = prescaler; }
+
+#if W25QXX_USE_CACHE
+    /**
+     * attach the read cache, or detach if null.
+     * the cache will be invalidated by write and erase methods.
+     */
+    inline void cache(w25qxx_cache_ctl_t* cache) {
+        if ((_cache = cache) != nullptr) {
+            _cache->clear();
+        }
+    }
+
+    /* get the attached read cache. */
+    inline w25qxx_cache_ctl_t* cache() const { return _cache; }
+#endif
+
     /**
      * read bytes from specified address.
+     * if the read cache attached, this will read through the cache.
      */
     uint32_t read(uint32_t addr, void* buf, uint32_t len, uint32_t timeout = 0xffffffffu);
 
+private:
+    /**
+     * (internal-only) read JEDEC ID and the reference bytes, and compare them.
+     */
+    bool verify(uint32_t id, uint32_t addr, const uint8_t* ref, uint32_t len);
+
+    /**
+     * (internal-only) read JEDEC ID.
+     */
+    uint32_t read_id();
+
+    /**
+     * (internal-only) read bytes from specified address without cache.
+     */
+    uint32_t read_raw(uint32_t addr, void* buf, uint32_t len, uint32_t timeout);
+
+#if W25QXX_USE_CACHE
+    /**
+     * (internal-only) read bytes through the read cache.
+     */
+    uint32_t read_cached(uint32_t addr, void* buf, uint32_t len, uint32_t timeout);
+#endif
+
+    /**
+     * (internal-only) invalidate the read cache for the range.
+     */
+    inline void invalidate(uint32_t addr, uint32_t len) {
+#if W25QXX_USE_CACHE
+        if (_cache) {
+            _cache->invalidate(addr, len);
+        }
+#else
+        (void) addr;
+        (void) len;
+#endif
+    }
+
+public:
+
     /**
      * read bytes from the specified page.
      * this can read over page boundary.
@@ -0,0 +1,157 @@
+#include "w25qxx_cache.h"
+
+w25qxx_cache_ctl_t::w25qxx_cache_ctl_t(uint8_t* data, uint32_t* tags, uint16_t* links, uint16_t* bucket,
+    uint16_t count, uint32_t line, uint16_t buckets)
+    : _data(data), _tags(tags),
+      _prev(links), _next(links + count), _chain(links + count * 2), _bucket(bucket),
+      _count(count), _mask(buckets - 1), _line(line),
+      _head(NIL), _tail(NIL), _hits(0), _misses(0)
+{
+    clear();
+}
+
+void w25qxx_cache_ctl_t::clear() {
+    for (uint16_t i = 0; i <= _mask; ++i) {
+        _bucket[i] = NIL;
+    }
+
+    // --> all lines are invalid, and linked in order.
+    for (uint16_t i = 0; i < _count; ++i) {
+        _tags[i] = NONE;
+        _chain[i] = NIL;
+        _prev[i] = i > 0 ? i - 1 : NIL;
+        _next[i] = i + 1 < _count ? i + 1 : NIL;
+    }
+
+    _head = 0;
+    _tail = _count - 1;
+}
+
+void w25qxx_cache_ctl_t::unlink(uint16_t n) {
+    if (_prev[n] != NIL) {
+        _next[_prev[n]] = _next[n];
+    }
+    else {
+        _head = _next[n];
+    }
+
+    if (_next[n] != NIL) {
+        _prev[_next[n]] = _prev[n];
+    }
+    else {
+        _tail = _prev[n];
+    }
+}
+
+void w25qxx_cache_ctl_t::push_front(uint16_t n) {
+    _prev[n] = NIL;
+    _next[n] = _head;
+
+    if (_head != NIL) {
+        _prev[_head] = n;
+    }
+
+    _head = n;
+    if (_tail == NIL) {
+        _tail = n;
+    }
+}
+
+uint16_t w25qxx_cache_ctl_t::find(uint32_t tag) const {
+    uint16_t n = _bucket[tag & _mask];
+    while (n != NIL) {
+        if (_tags[n] == tag) {
+            return n;
+        }
+
+        n = _chain[n];
+    }
+
+    return NIL;
+}
+
+void w25qxx_cache_ctl_t::drop(uint16_t n) {
+    if (_tags[n] == NONE) {
+        return;
+    }
+
+    uint16_t* slot = &_bucket[_tags[n] & _mask];
+    while (*slot != NIL) {
+        if (*slot == n) {
+            *slot = _chain[n];
+            break;
+        }
+
+        slot = &_chain[*slot];
+    }
+
+    _tags[n] = NONE;
+    _chain[n] = NIL;
+
+    // --> invalid lines are reused first.
+    if (_tail != n) {
+        unlink(n);
+
+        _prev[n] = _tail;
+        _next[n] = NIL;
+        _next[_tail] = n;
+        _tail = n;
+    }
+}
+
+uint8_t* w25qxx_cache_ctl_t::lookup(uint32_t tag) {
+    uint16_t n = find(tag);
+    if (n == NIL) {
+        ++_misses;
+        return nullptr;
+    }
+
+    ++_hits;
+    if (_head != n) {
+        unlink(n);
+        push_front(n);
+    }
+
+    return _data + n * _line;
+}
+
+uint8_t* w25qxx_cache_ctl_t::assign(uint32_t tag) {
+    uint16_t n = _tail;
+
+    drop(n);
+    unlink(n);
+    push_front(n);
+
+    _tags[n] = tag;
+    _chain[n] = _bucket[tag & _mask];
+    _bucket[tag & _mask] = n;
+
+    return _data + n * _line;
+}
+
+void w25qxx_cache_ctl_t::invalidate(uint32_t addr, uint32_t len) {
+    if (!len) {
+        return;
+    }
+
+    uint32_t first = addr / _line;
+    uint32_t last = (addr + len - 1) / _line;
+
+    // --> wide range (e.g. block erase): scan all lines instead.
+    if (last - first >= _count) {
+        for (uint16_t i = 0; i < _count; ++i) {
+            if (_tags[i] != NONE && _tags[i] >= first && _tags[i] <= last) {
+                drop(i);
+            }
+        }
+
+        return;
+    }
+
+    for (uint32_t tag = first; tag <= last; ++tag) {
+        uint16_t n = find(tag);
+        if (n != NIL) {
+            drop(n);
+        }
+    }
+}
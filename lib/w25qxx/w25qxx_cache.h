@@ -0,0 +1,122 @@
+#ifndef __W25QXX_CACHE_H__
+#define __W25QXX_CACHE_H__
+
+#include <stdint.h>
+
+/**
+ * Describes a read cache controller for w25qxx_t.
+ * this keeps N lines with LRU order and hash index, both O(1).
+ * the storage is provided by `w25qxx_cache_t<count, lsize>`.
+ */
+class w25qxx_cache_ctl_t {
+public:
+    static constexpr uint16_t NIL = 0xffffu;
+    static constexpr uint32_t NONE = 0xffffffffu;
+
+private:
+    uint8_t* _data;
+    uint32_t* _tags;
+    uint16_t* _prev;
+    uint16_t* _next;
+    uint16_t* _chain;
+    uint16_t* _bucket;
+
+    uint16_t _count;
+    uint16_t _mask;     // --> bucket mask.
+    uint32_t _line;     // --> line size in bytes.
+    uint16_t _head;     // --> most recently used.
+    uint16_t _tail;     // --> least recently used.
+
+    uint32_t _hits;
+    uint32_t _misses;
+
+public:
+    /**
+     * initialize a new cache controller on the storage.
+     * `buckets` must be power of 2.
+     */
+    w25qxx_cache_ctl_t(uint8_t* data, uint32_t* tags, uint16_t* links, uint16_t* bucket,
+        uint16_t count, uint32_t line, uint16_t buckets);
+
+public:
+    /* line size in bytes. */
+    inline uint32_t line() const { return _line; }
+
+    /* total size in bytes. */
+    inline uint32_t size() const { return _line * _count; }
+
+    /* cache hit count. */
+    inline uint32_t hits() const { return _hits; }
+
+    /* cache miss count. */
+    inline uint32_t misses() const { return _misses; }
+
+    /* reset hit/miss counters. */
+    inline void reset() { _hits = _misses = 0; }
+
+public:
+    /**
+     * find the line for the tag (= addr / line).
+     * returns null if not cached, and counts hit/miss.
+     */
+    uint8_t* lookup(uint32_t tag);
+
+    /**
+     * evict the least recently used line and assign it to the tag.
+     * the caller must fill the returned line.
+     */
+    uint8_t* assign(uint32_t tag);
+
+    /**
+     * invalidate all lines that overlap the range.
+     */
+    void invalidate(uint32_t addr, uint32_t len);
+
+    /**
+     * invalidate all lines.
+     */
+    void clear();
+
+private:
+    /* unlink the line from LRU list. */
+    void unlink(uint16_t n);
+
+    /* link the line to head of LRU list. */
+    void push_front(uint16_t n);
+
+    /* remove the line from hash index and mark it as invalid. */
+    void drop(uint16_t n);
+
+    /* find the line index for the tag, or NIL. */
+    uint16_t find(uint32_t tag) const;
+};
+
+/**
+ * Describes a read cache storage for w25qxx_t.
+ * RAM usage: count * (lsize + 10) + buckets * 2 bytes.
+ * e.g. w25qxx_cache_t<16> --> 16 lines of 256 bytes, about 4.2 KB.
+ */
+template<uint16_t count, uint32_t lsize = 256>
+class w25qxx_cache_t : public w25qxx_cache_ctl_t {
+private:
+    static constexpr uint16_t buckets(uint16_t n, uint16_t x = 1) {
+        return x >= n ? x : buckets(n, x << 1);
+    }
+
+    static_assert(count > 0 && count < NIL, "count must be in 1 ~ 65534.");
+    static_assert(lsize > 0 && (lsize & (lsize - 1)) == 0, "lsize must be power of 2.");
+
+private:
+    uint8_t _storage[count * lsize];
+    uint32_t _tagbuf[count];
+    uint16_t _links[count * 3];
+    uint16_t _buckets[buckets(count)];
+
+public:
+    w25qxx_cache_t()
+        : w25qxx_cache_ctl_t(_storage, _tagbuf, _links, _buckets, count, lsize, buckets(count))
+    {
+    }
+};
+
+#endif // __W25QXX_CACHE_H__
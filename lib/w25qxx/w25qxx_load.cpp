@@ -0,0 +1,229 @@
+#include "w25qxx_load.h"
+
+// --> CRC32 (poly 0xedb88320, reflected), 4 bits per step.
+static const uint32_t W25QXX_CRC_TABLE[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+static inline uint32_t load_rd32(const uint8_t* p) {
+    return p[0] | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static inline void load_wr32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v); p[1] = uint8_t(v >> 8);
+    p[2] = uint8_t(v >> 16); p[3] = uint8_t(v >> 24);
+}
+
+uint32_t w25qxx_load_t::crc32(const void* buf, uint32_t len, uint32_t crc) {
+    const uint8_t* p = (const uint8_t*) buf;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ W25QXX_CRC_TABLE[crc & 15];
+        crc = (crc >> 4) ^ W25QXX_CRC_TABLE[crc & 15];
+    }
+
+    return ~crc;
+}
+
+uint8_t w25qxx_load_t::poll() {
+    uint32_t len;
+    const uint8_t* buf = _reader.next(len);
+
+    if (!buf) {
+        // --> nothing to do: erase ahead of the window.
+        if (_state == BUSY) {
+            uint32_t until = _addr + (_next + WINDOW) * CHUNK + w25qxx_t::SECTOR_SIZE;
+
+            if (!erase_next(until)) {
+                _state = FAILED;
+            }
+        }
+
+        return _state;
+    }
+
+    if (len < 5 || crc32(buf, len - 4) != load_rd32(buf + len - 4)) {
+        _errors++;
+    }
+
+    else {
+        switch (buf[0]) {
+            case 0x01: on_start(buf, len - 4); break;
+            case 0x02: on_data(buf, len - 4); break;
+            case 0x03: on_end(); break;
+            default:
+                _errors++;
+                break;
+        }
+    }
+
+    _reader.release();
+    return _state;
+}
+
+void w25qxx_load_t::on_start(const uint8_t* buf, uint32_t len) {
+    uint8_t res[5] = { 0x82, 1, uint8_t(WINDOW), uint8_t(CHUNK & 0xff), uint8_t(CHUNK >> 8) };
+
+    if (len == 13) {
+        uint32_t addr = load_rd32(buf + 1);
+        uint32_t size = load_rd32(buf + 5);
+
+        // --> the first sector is erased entirely, so it must be aligned.
+        if ((addr % w25qxx_t::SECTOR_SIZE) == 0 && size &&
+            addr < _flash.max_addr() && size <= _flash.max_addr() - addr)
+        {
+            _addr = addr;
+            _len = size;
+            _crc = load_rd32(buf + 9);
+
+            _next = _bitmap = 0;
+            _erased = addr;
+            _state = BUSY;
+            res[1] = 0;
+        }
+    }
+
+    reply(res, sizeof(res));
+}
+
+void w25qxx_load_t::on_data(const uint8_t* buf, uint32_t len) {
+    if (_state != BUSY || len < 5) {
+        return;
+    }
+
+    uint32_t seq = load_rd32(buf + 1);
+    uint32_t n = len - 5;
+
+    if (seq >= frames()) {
+        _errors++;
+        return;
+    }
+
+    // --> every payload has CHUNK bytes, except the last one.
+    uint32_t offset = seq * CHUNK;
+    uint32_t expect = _len - offset < CHUNK ? _len - offset : CHUNK;
+
+    if (n != expect) {
+        _errors++;
+        return;
+    }
+
+    // --> duplicated, or out of the window: the ACK tells the host what to send.
+    uint32_t i = seq - _next;
+    if (seq < _next || i >= WINDOW || (_bitmap & (1u << i))) {
+        reply_ack();
+        return;
+    }
+
+    uint32_t addr = _addr + offset;
+    while (_erased < addr + n) {
+        if (!erase_next(addr + n)) {
+            _state = FAILED;
+
+            uint8_t res[2] = { 0x83, 2 };
+            reply(res, sizeof(res));
+            return;
+        }
+    }
+
+    // --> straight from the RX ring to the flash.
+    if (_flash.write(addr, buf + 5, n, 100) != n) {
+        _errors++;
+        reply_ack();
+        return;
+    }
+
+    _bitmap |= 1u << i;
+    while (_bitmap & 1) {
+        _bitmap >>= 1;
+        _next++;
+    }
+
+    reply_ack();
+}
+
+void w25qxx_load_t::on_end() {
+    uint8_t res[2] = { 0x83, 0 };
+
+    if (_state == BUSY) {
+        if (_next < frames()) {
+            reply_ack();
+            return;
+        }
+
+        _state = verify() ? DONE : FAILED;
+    }
+
+    // --> reply again if the host lost the last one.
+    if (_state == IDLE) {
+        return;
+    }
+
+    res[1] = _state == DONE ? 0 : 1;
+    reply(res, sizeof(res));
+}
+
+bool w25qxx_load_t::erase_next(uint32_t until) {
+    uint32_t end = (_addr + _len + w25qxx_t::SECTOR_SIZE - 1) & ~(w25qxx_t::SECTOR_SIZE - 1);
+
+    if (_erased >= until || _erased >= end) {
+        return true;
+    }
+
+    // --> a 64 KB block erase is several times faster than 16 sectors.
+    if ((_erased % w25qxx_t::BLOCK_SIZE) == 0 && _erased + w25qxx_t::BLOCK_SIZE <= end) {
+        if (!_flash.erase_block(_erased / w25qxx_t::BLOCK_SIZE)) {
+            return false;
+        }
+
+        _erased += w25qxx_t::BLOCK_SIZE;
+        return true;
+    }
+
+    if (!_flash.erase_sector(_erased / w25qxx_t::SECTOR_SIZE)) {
+        return false;
+    }
+
+    _erased += w25qxx_t::SECTOR_SIZE;
+    return true;
+}
+
+bool w25qxx_load_t::verify() {
+    uint8_t buf[CHUNK];
+    uint32_t crc = 0;
+
+    for (uint32_t offset = 0; offset < _len; offset += CHUNK) {
+        uint32_t n = _len - offset < CHUNK ? _len - offset : CHUNK;
+
+        if (_flash.read(_addr + offset, buf, n, 100) != n) {
+            return false;
+        }
+
+        crc = crc32(buf, n, crc);
+    }
+
+    return crc == _crc;
+}
+
+void w25qxx_load_t::reply(const uint8_t* buf, uint32_t len) {
+    uint8_t frame[16];
+
+    memcpy(frame, buf, len);
+    load_wr32(frame + len, crc32(frame, len));
+
+    // --> dropped if the TX queue is full: the host retries on timeout.
+    frame_t::encode(_uart, frame_t::COBS, frame, len + 4);
+}
+
+void w25qxx_load_t::reply_ack() {
+    uint8_t res[9] = { 0x81 };
+
+    load_wr32(res + 1, _next);
+    load_wr32(res + 5, _bitmap);
+    reply(res, sizeof(res));
+}
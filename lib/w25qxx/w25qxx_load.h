@@ -0,0 +1,118 @@
+#ifndef __W25QXX_LOAD_H__
+#define __W25QXX_LOAD_H__
+
+#include "w25qxx.h"
+#include "../uart/uart.h"
+#include "../frame/frame.h"
+
+#if !UART_USE_RING
+#error "w25qxx_load requires UART_USE_RING = 1."
+#endif
+
+// --> frames in flight, up to 32. the RX ring should hold this many frames. (about 270 bytes each)
+#ifndef W25QXX_LOAD_WINDOW
+#define W25QXX_LOAD_WINDOW  16
+#endif
+
+/**
+ * Describes a receiver of the windowed transfer, programming the flash from the UART.
+ * --
+ * host --> device, COBS framed, and each frame ends with CRC32 (LE) of the rest:
+ *  START: [0x01] [addr: 4] [length: 4] [image CRC32: 4]
+ *  DATA : [0x02] [seq: 4] [payload: CHUNK bytes, except the last one]  --> offset = seq * CHUNK.
+ *  END  : [0x03]
+ * device --> host:
+ *  READY: [0x82] [status: 1] [window: 1] [chunk: 2]
+ *  ACK  : [0x81] [next: 4] [bitmap: 4]  --> all below `next` written, bit i: `next + i` written.
+ *  DONE : [0x83] [status: 1]            --> 0: image CRC matched, or ACK if frames missing.
+ * --
+ * the payload goes to its own offset, so out of order frames are programmed without reordering.
+ * sectors are erased ahead while no frame is ready. (blocks, if the image covers them)
+ */
+class w25qxx_load_t {
+public:
+    static constexpr uint32_t CHUNK = w25qxx_t::PAGE_SIZE;
+    static constexpr uint32_t WINDOW = W25QXX_LOAD_WINDOW;
+
+    static_assert(WINDOW > 0 && WINDOW <= 32, "W25QXX_LOAD_WINDOW must be 1 ~ 32.");
+
+    /* `poll` results. */
+    static constexpr uint8_t IDLE = 0;
+    static constexpr uint8_t BUSY = 1;
+    static constexpr uint8_t DONE = 2;
+    static constexpr uint8_t FAILED = 3;
+
+private:
+    static constexpr uint32_t MAX_FRAME = 1 + 4 + CHUNK + 4;
+
+    w25qxx_t& _flash;
+    uart_base_t& _uart;
+    frame_reader_t _reader;
+    uint8_t _scratch[frame_t::bound(frame_t::COBS, MAX_FRAME)];
+
+    uint8_t _state;
+    uint32_t _addr;     // --> image start address.
+    uint32_t _len;      // --> image length.
+    uint32_t _crc;      // --> image CRC32.
+
+    uint32_t _next;     // --> the lowest seq not written.
+    uint32_t _bitmap;   // --> bit i: `_next + i` written.
+    uint32_t _erased;   // --> end address of the erased range.
+
+    uint32_t _errors;
+
+public:
+    /**
+     * initialize a new receiver on the UART, and its RX ring.
+     * the UART must be running `begin_ring(rx)` and `begin_tx`.
+     */
+    w25qxx_load_t(w25qxx_t& flash, uart_base_t& uart, ring_t& rx)
+        : _flash(flash), _uart(uart), _reader(rx, frame_t::COBS, _scratch, sizeof(_scratch)),
+          _state(IDLE), _addr(0), _len(0), _crc(0), _next(0), _bitmap(0), _erased(0),
+          _errors(0)
+    {
+    }
+
+public:
+    /* compute CRC32. (IEEE 802.3, same as zlib) */
+    static uint32_t crc32(const void* buf, uint32_t len, uint32_t crc = 0);
+
+public:
+    /**
+     * handle received frames, and erase ahead if nothing to do.
+     * call this repeatedly from the main loop, and returns the state.
+     */
+    uint8_t poll();
+
+    /* get the state. */
+    inline uint8_t state() const { return _state; }
+
+    /* get the count of bytes written in order. */
+    inline uint32_t written() const {
+        uint32_t n = _next * CHUNK;
+        return n < _len ? n : _len;
+    }
+
+    /* get the count of frames dropped by CRC or framing error. */
+    inline uint32_t errors() const { return _errors + _reader.errors(); }
+
+private:
+    /* get the count of DATA frames. */
+    inline uint32_t frames() const { return (_len + CHUNK - 1) / CHUNK; }
+
+    void on_start(const uint8_t* buf, uint32_t len);
+    void on_data(const uint8_t* buf, uint32_t len);
+    void on_end();
+
+    /* erase the next sector (or block), until `until`. */
+    bool erase_next(uint32_t until);
+
+    /* test whether CRC32 of the image in the flash matches. */
+    bool verify();
+
+    /* send a frame with CRC32. */
+    void reply(const uint8_t* buf, uint32_t len);
+    void reply_ack();
+};
+
+#endif // __W25QXX_LOAD_H__
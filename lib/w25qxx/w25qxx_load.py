@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+w25qxx_load sender: programs an image through `w25qxx_load_t` with the windowed transfer.
+
+usage:
+    python3 w25qxx_load.py /dev/ttyUSB0 image.bin --addr 0x100000 --baud 921600
+    python3 w25qxx_load.py /dev/pts/5 image.bin     (pty: e.g. w25qxx_load_host, the host receiver)
+
+only the standard library is used. (termios, POSIX)
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+import zlib
+
+START, DATA, END = 0x01, 0x02, 0x03
+ACK, READY, DONE = 0x81, 0x82, 0x83
+
+
+def cobs_encode(buf):
+    out = bytearray()
+    block = bytearray()
+
+    for b in buf:
+        if b == 0:
+            out.append(len(block) + 1)
+            out += block
+            block = bytearray()
+            continue
+
+        block.append(b)
+        if len(block) == 254:
+            out.append(255)
+            out += block
+            block = bytearray()
+
+    out.append(len(block) + 1)
+    out += block
+    out.append(0)
+    return bytes(out)
+
+
+def cobs_decode(buf):
+    out = bytearray()
+    i = 0
+
+    while i < len(buf):
+        code = buf[i]
+        if code == 0 or i + code > len(buf):
+            return None
+
+        out += buf[i + 1:i + code]
+        i += code
+
+        if code != 0xff and i < len(buf):
+            out.append(0)
+
+    return bytes(out)
+
+
+class Link:
+    """COBS framed link with CRC32, on a tty or pty."""
+
+    def __init__(self, path, baud):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        self.pending = bytearray()
+
+        tty.setraw(self.fd)
+        speed = getattr(termios, "B%d" % baud, None)
+        if speed is not None:
+            attr = termios.tcgetattr(self.fd)
+            attr[4] = attr[5] = speed
+            termios.tcsetattr(self.fd, termios.TCSANOW, attr)
+
+    def send(self, payload):
+        frame = cobs_encode(payload + struct.pack("<I", zlib.crc32(payload)))
+        view = memoryview(frame)
+
+        while view:
+            view = view[os.write(self.fd, view):]
+
+    def recv(self, timeout):
+        """returns the next valid frame, or None on timeout."""
+        limit = time.monotonic() + timeout
+
+        while True:
+            while b"\0" in self.pending:
+                stop = self.pending.index(b"\0")
+                frame = cobs_decode(bytes(self.pending[:stop]))
+                del self.pending[:stop + 1]
+
+                if frame and len(frame) > 4:
+                    body, crc = frame[:-4], struct.unpack("<I", frame[-4:])[0]
+                    if zlib.crc32(body) == crc:
+                        return body
+
+            left = limit - time.monotonic()
+            if left <= 0 or not select.select([self.fd], [], [], left)[0]:
+                return None
+
+            self.pending += os.read(self.fd, 4096)
+
+
+def program(link, image, addr, timeout, retries):
+    # --> START: the device checks the range, and tells the window.
+    for _ in range(retries):
+        link.send(struct.pack("<BIII", START, addr, len(image), zlib.crc32(image)))
+        res = link.recv(timeout)
+        if res and res[0] == READY:
+            break
+    else:
+        raise RuntimeError("no response to START")
+
+    status, window, chunk = struct.unpack_from("<BBH", res, 1)
+    if status:
+        raise RuntimeError("START rejected: address %#x, length %d" % (addr, len(image)))
+
+    count = (len(image) + chunk - 1) // chunk
+    next_seq, bitmap = 0, 0
+    sent = {}       # --> seq: (time, order)
+    order = 0
+    begin = time.monotonic()
+
+    while next_seq < count:
+        now = time.monotonic()
+
+        # --> the highest order acknowledged: missing frames sent before it are lost.
+        acked = max([sent[next_seq + i][1] for i in range(window)
+                     if bitmap >> i & 1 and next_seq + i in sent] or [-1])
+
+        for seq in range(next_seq, min(next_seq + window, count)):
+            if bitmap >> (seq - next_seq) & 1:
+                continue
+
+            if seq in sent and sent[seq][1] > acked and now - sent[seq][0] < timeout:
+                continue
+
+            link.send(struct.pack("<BI", DATA, seq) + image[seq * chunk:(seq + 1) * chunk])
+            sent[seq] = (now, order)
+            order += 1
+
+        res = link.recv(timeout)
+        if res and res[0] == ACK:
+            n, bitmap = struct.unpack_from("<II", res, 1)
+            for seq in range(next_seq, n):
+                sent.pop(seq, None)
+
+            next_seq = max(next_seq, n)
+            done = next_seq * chunk
+            rate = done / max(time.monotonic() - begin, 1e-6)
+            sys.stderr.write("\r%d / %d bytes, %.1f KB/s" % (min(done, len(image)), len(image), rate / 1024))
+
+    sys.stderr.write("\n")
+
+    # --> END: the device verifies CRC32 of the flash.
+    for _ in range(retries):
+        link.send(bytes([END]))
+        res = link.recv(timeout * 4)
+        if res and res[0] == DONE:
+            return res[1] == 0
+
+    raise RuntimeError("no response to END")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="w25qxx_load sender")
+    parser.add_argument("port", help="tty or pty path")
+    parser.add_argument("image", help="binary image to program")
+    parser.add_argument("--addr", type=lambda x: int(x, 0), default=0, help="flash address, sector aligned")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=0.5, help="seconds to retransmit")
+    parser.add_argument("--retries", type=int, default=10)
+    opts = parser.parse_args()
+
+    with open(opts.image, "rb") as f:
+        image = f.read()
+
+    link = Link(opts.port, opts.baud)
+    if program(link, image, opts.addr, opts.timeout, opts.retries):
+        print("done: %d bytes at %#x, CRC32 matched." % (len(image), opts.addr))
+        return 0
+
+    print("failed: CRC32 mismatch.")
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,359 @@
+/**
+ * w25qxx_load host receiver: runs `w25qxx_load_t` and `w25qxx_t` against a RAM-backed flash, behind a pty.
+ * the flash answers the SPI commands of the driver at the HAL level, and programs like the chip:
+ * a page program wraps in the page and only clears bits, and runs when CS goes high.
+ * the UART side copies the pty bytes into the RX ring as the circular DMA, and sends replies to the pty.
+ * host only: excluded from ARM builds, so the folder can be copied into the firmware as is.
+ * --
+ * build: (with the host `main.h`, see `../host`)
+ *  g++ -std=c++11 -DUART_USE_RING=1 -I../host w25qxx_load_host.cpp w25qxx_load.cpp w25qxx.cpp \
+ *      ../spi/spi.cpp ../pin/pin.cpp ../uart/uart.cpp ../frame/frame.cpp ../host/hal.cpp -o w25qxx_load_host
+ *
+ * usage:
+ *  ./w25qxx_load_host [--lose SEQ]... [--corrupt SEQ]... [--out flash.bin]
+ *  python3 w25qxx_load.py /dev/pts/N image.bin --addr 0x10000     (the path printed by the receiver)
+ *  --lose SEQ : drop the first DATA frame of SEQ, then the sender resends it from the ACK bitmap.
+ *  --corrupt SEQ : flip a bit in the first DATA frame of SEQ, then the receiver drops it by CRC.
+ */
+#if !defined(__arm__)
+
+#include "w25qxx_load.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <set>
+#include <vector>
+
+// --> 2 MB, W25Q16. (JEDEC ID: ef 40 15)
+static constexpr uint32_t FLASH_SIZE = 32 * w25qxx_t::BLOCK_SIZE;
+
+/**
+ * RAM-backed W25Qxx on the SPI HAL. a command is the bytes between CS low and high.
+ */
+class ram_flash_t {
+private:
+    std::vector<uint8_t> _mem;
+    std::vector<uint8_t> _cmd;      // --> bytes of the current command.
+    bool _selected;
+    bool _wel;                      // --> write enable latch.
+
+public:
+    uint32_t programs;              // --> page programs.
+    uint32_t erases;                // --> sector and block erases.
+    uint32_t dirty;                 // --> bits programmed from 0 to 1: not erased before.
+
+public:
+    ram_flash_t() : _mem(FLASH_SIZE, 0x00), _selected(false), _wel(false), programs(0), erases(0), dirty(0) { }
+
+    /* get the memory. */
+    inline const uint8_t* data() const { return &_mem[0]; }
+
+    /* CS edge. */
+    void select(bool low) {
+        if (low && !_selected) {
+            _cmd.clear();
+        }
+
+        if (!low && _selected) {
+            finish();
+        }
+
+        _selected = low;
+    }
+
+    /* exchange bytes while selected. */
+    void xfer(const uint8_t* tx, uint8_t* rx, uint32_t len) {
+        for (uint32_t i = 0; i < len; ++i) {
+            uint8_t out = shift();
+            _cmd.push_back(tx ? tx[i] : 0xff);
+
+            if (rx) {
+                rx[i] = out;
+            }
+        }
+    }
+
+private:
+    inline uint32_t addr() const {
+        return (uint32_t(_cmd[1]) << 16) | (uint32_t(_cmd[2]) << 8) | _cmd[3];
+    }
+
+    /* get the byte shifted out for the next position of the command. */
+    uint8_t shift() const {
+        static const uint8_t JEDEC[3] = { 0xef, 0x40, 0x15 };
+        uint32_t pos = uint32_t(_cmd.size());
+
+        if (!_selected || pos == 0) {
+            return 0xff;
+        }
+
+        switch (_cmd[0]) {
+            case 0x05: return _wel ? 0x02 : 0x00;   // --> never busy: commands complete at CS high.
+            case 0x9f: return pos <= 3 ? JEDEC[pos - 1] : 0xff;
+            case 0x03: return pos >= 4 ? _mem[(addr() + pos - 4) % FLASH_SIZE] : 0xff;
+            default:
+                break;
+        }
+
+        return 0xff;
+    }
+
+    /* run the command at CS high. */
+    void finish() {
+        if (_cmd.empty()) {
+            return;
+        }
+
+        switch (_cmd[0]) {
+            case 0x06: _wel = true; return;
+            case 0x04: _wel = false; return;
+            case 0x02: if (_wel && _cmd.size() > 4) { program(); } break;
+            case 0x20: if (_wel && _cmd.size() == 4) { erase(addr() & ~(w25qxx_t::SECTOR_SIZE - 1), w25qxx_t::SECTOR_SIZE); } break;
+            case 0xd8: if (_wel && _cmd.size() == 4) { erase(addr() & ~(w25qxx_t::BLOCK_SIZE - 1), w25qxx_t::BLOCK_SIZE); } break;
+            default:
+                return;
+        }
+
+        _wel = false;
+    }
+
+    /* the address wraps in the page, and bits are only cleared. */
+    void program() {
+        uint32_t page = addr() & ~(w25qxx_t::PAGE_SIZE - 1);
+        uint32_t offset = addr() % w25qxx_t::PAGE_SIZE;
+
+        for (uint32_t i = 4; i < _cmd.size(); ++i) {
+            uint8_t& cell = _mem[(page + offset) % FLASH_SIZE];
+
+            dirty += (_cmd[i] & ~cell) ? 1 : 0;
+            cell &= _cmd[i];
+            offset = (offset + 1) % w25qxx_t::PAGE_SIZE;
+        }
+
+        programs++;
+    }
+
+    void erase(uint32_t addr, uint32_t len) {
+        memset(&_mem[addr % FLASH_SIZE], 0xff, len);
+        erases++;
+    }
+};
+
+static ram_flash_t g_flash;
+static GPIO_TypeDef g_gpio;     // --> port of the CS pin.
+static SPI_HandleTypeDef g_hspi;
+
+static int g_pty = -1;
+static UART_HandleTypeDef g_huart;
+static USART_TypeDef g_usart;
+static DMA_Stream_TypeDef g_rxstream;
+static DMA_HandleTypeDef g_hdmarx;
+static bool g_sending = false;
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t, GPIO_PinState state) {
+    if (port == &g_gpio) {
+        g_flash.select(state == GPIO_PIN_RESET);
+    }
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef*, uint8_t* buf, uint16_t len, uint32_t) {
+    g_flash.xfer(buf, nullptr, len);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef*, uint8_t* buf, uint16_t len, uint32_t) {
+    g_flash.xfer(nullptr, buf, len);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef*, uint8_t* tx, uint8_t* rx, uint16_t len, uint32_t) {
+    g_flash.xfer(tx, rx, len);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef*, uint8_t* buf, uint16_t len) {
+    if (g_sending) {
+        return HAL_BUSY;
+    }
+
+    while (len) {
+        ssize_t n = write(g_pty, buf, len);
+        if (n <= 0) {
+            break;      // --> the sender is gone: the reply is lost, as on the wire.
+        }
+
+        buf += n;
+        len -= uint16_t(n);
+    }
+
+    g_sending = true;
+    return HAL_OK;
+}
+
+/**
+ * Splits the pty bytes into frames, to lose or corrupt the first copy of a DATA frame.
+ */
+class injector_t {
+private:
+    std::vector<uint8_t> _frame;
+    std::set<uint32_t> _lose;
+    std::set<uint32_t> _corrupt;
+
+public:
+    void lose(uint32_t seq) { _lose.insert(seq); }
+    void corrupt(uint32_t seq) { _corrupt.insert(seq); }
+
+    /* feed a byte, and returns the bytes to receive when the frame ends. */
+    bool feed(uint8_t b, std::vector<uint8_t>& out) {
+        _frame.push_back(b);
+        if (b != 0) {
+            return false;
+        }
+
+        out.swap(_frame);
+        _frame.clear();
+
+        std::vector<uint8_t> body(out.begin(), out.end() - 1);
+        uint32_t len = frame_t::decode_cobs(body.data(), uint32_t(body.size()));
+
+        if (len == 0xffffffffu || len < 5 || body[0] != 0x02) {
+            return true;
+        }
+
+        uint32_t seq = body[1] | (uint32_t(body[2]) << 8) | (uint32_t(body[3]) << 16) | (uint32_t(body[4]) << 24);
+
+        if (_lose.erase(seq)) {
+            fprintf(stderr, "lost DATA %u\n", seq);
+            out.clear();
+        }
+
+        else if (_corrupt.erase(seq) && out.size() > 8) {
+            fprintf(stderr, "corrupted DATA %u\n", seq);
+            out[out.size() / 2] ^= 0x10;
+            if (!out[out.size() / 2]) {
+                out[out.size() / 2] = 0x10;  // --> keep the delimiter out of the frame.
+            }
+        }
+
+        return true;
+    }
+};
+
+int main(int argc, char** argv) {
+    injector_t inject;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--lose") && i + 1 < argc) {
+            inject.lose(uint32_t(strtoul(argv[++i], nullptr, 0)));
+        }
+
+        else if (!strcmp(argv[i], "--corrupt") && i + 1 < argc) {
+            inject.corrupt(uint32_t(strtoul(argv[++i], nullptr, 0)));
+        }
+
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            path = argv[++i];
+        }
+
+        else {
+            fprintf(stderr, "usage: %s [--lose SEQ]... [--corrupt SEQ]... [--out flash.bin]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    g_pty = posix_openpt(O_RDWR | O_NOCTTY);
+    if (g_pty < 0 || grantpt(g_pty) || unlockpt(g_pty)) {
+        perror("pty");
+        return 1;
+    }
+
+    printf("%s\n", ptsname(g_pty));
+    fflush(stdout);
+
+    // --> the flash behind the SPI HAL.
+    w25qxx_t flash(spi_t(&g_hspi), pin_t(&g_gpio, 1));
+    if (!flash.recognize()) {
+        fprintf(stderr, "flash: not recognized.\n");
+        return 1;
+    }
+
+    // --> the UART with the circular RX DMA.
+    static ring_buf_t<8192> rx;
+    static ring_buf_t<256> tx;
+    uart_base_t uart(&g_huart);
+
+    g_huart.Instance = &g_usart;
+    g_hdmarx.Instance = &g_rxstream;
+    g_hdmarx.Init.Mode = DMA_CIRCULAR;
+    g_huart.hdmarx = &g_hdmarx;
+
+    uart.enable();
+    uart.begin_ring(rx);
+    uart.begin_tx(tx);
+
+    w25qxx_load_t loader(flash, uart, rx);
+    uint32_t pos = 0;
+    uint8_t state = w25qxx_load_t::IDLE;
+    uint32_t quiet = 0;
+
+    // --> serve until one second after DONE or FAILED, to answer the sender again if it lost the reply.
+    while (quiet < 1000 || (state != w25qxx_load_t::DONE && state != w25qxx_load_t::FAILED)) {
+        struct pollfd pfd = { g_pty, POLLIN, 0 };
+        uint8_t buf[512];
+        ssize_t n = 0;
+
+        if (poll(&pfd, 1, 1) > 0 && (pfd.revents & POLLIN)) {
+            n = read(g_pty, buf, sizeof(buf));
+        }
+
+        quiet = n > 0 ? 0 : quiet + 1;
+
+        for (ssize_t i = 0; i < n; ++i) {
+            std::vector<uint8_t> bytes;
+            if (!inject.feed(buf[i], bytes)) {
+                continue;
+            }
+
+            // --> as the circular DMA: IDLE event after the frame, and a full event at the end of the storage.
+            for (uint8_t b : bytes) {
+                rx.data()[pos] = b;
+                pos = (pos + 1) % rx.size();
+
+                if (!pos) {
+                    HAL_UARTEx_RxEventCallback(&g_huart, uint16_t(rx.size()));
+                }
+            }
+
+            if (!bytes.empty()) {
+                HAL_UARTEx_RxEventCallback(&g_huart, uint16_t(pos));
+            }
+        }
+
+        if (g_sending) {
+            g_sending = false;
+            HAL_UART_TxCpltCallback(&g_huart);
+        }
+
+        state = loader.poll();
+    }
+
+    fprintf(stderr, "%s: %u bytes in order, %u frames dropped, %u page programs, %u erases, %u dirty bytes.\n",
+        state == w25qxx_load_t::DONE ? "done" : "failed", loader.written(), loader.errors(),
+        g_flash.programs, g_flash.erases, g_flash.dirty);
+
+    if (path) {
+        FILE* fp = fopen(path, "wb");
+        if (fp) {
+            fwrite(g_flash.data(), 1, FLASH_SIZE, fp);
+            fclose(fp);
+        }
+    }
+
+    return state == w25qxx_load_t::DONE && !g_flash.dirty ? 0 : 1;
+}
+
+#endif
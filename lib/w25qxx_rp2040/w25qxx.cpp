@@ -35,7 +35,7 @@ const uint16_t W25QXX::MODELS[MODEL_MAX] = {
 };
 
 W25QXX::W25QXX(spi_inst_t* dev, uint8_t csn, uint8_t clk, uint8_t miso, uint8_t mosi)
-    : _dev(dev), _csn(csn), _clk(clk), _miso(miso), _mosi(mosi), _init(0), _sel(0), _id(0), _bcnt(0)
+    : _dev(dev), _csn(csn), _clk(clk), _miso(miso), _mosi(mosi), _init(0), _sel(0), _id(0), _bcnt(0), _baud(BAUDRATE)
 {
 }
 
@@ -135,8 +135,81 @@ bool W25QXX::fastMode(bool val) {
 }
 #endif
 
+uint32_t W25QXX::baudRate(uint32_t baud) {
+    if (!_dev) {
+        return 0;
+    }
+
+    return _baud = spi_set_baudrate(_dev, baud);
+}
+
+bool W25QXX::verify(uint32_t addr, const uint8_t* ref, uint32_t len) {
+    uint8_t temp[CALIB_LEN];
+
+    for (uint32_t i = 0; i < CALIB_ROUNDS; ++i) {
+        if (readId() != _id) {
+            return false;
+        }
+
+        if (read(addr, temp, len) != len || memcmp(temp, ref, len) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t W25QXX::calibrate(uint32_t addr, uint32_t maxBaud, uint8_t margin) {
+    uint8_t ref[CALIB_LEN];
+    uint32_t steps[16];
+    uint32_t count = 0;
+
+    if (!_dev || !_bcnt || addr >= capacity()) {
+        return 0;
+    }
+
+    uint32_t len = capacity() - addr;
+    if (len > sizeof(ref)) {
+        len = sizeof(ref);
+    }
+
+    uint32_t prev = _baud;
+    waitForWrite();
+
+    // --> baseline at the slowest clock.
+    baudRate(CALIB_BAUDRATE);
+    if (readId() != _id || read(addr, ref, len) != len) {
+        baudRate(prev);
+        return 0;
+    }
+
+    // --> double the baud-rate until the first failure.
+    for (uint32_t baud = CALIB_BAUDRATE; baud <= maxBaud && count < 16; baud *= 2) {
+        uint32_t actual = baudRate(baud);
+
+        // --> clamped by the peripheral clock.
+        if (count && actual == steps[count - 1]) {
+            break;
+        }
+
+        if (!verify(addr, ref, len)) {
+            break;
+        }
+
+        steps[count++] = actual;
+    }
+
+    // --> unstable even at the slowest clock.
+    if (!count) {
+        baudRate(prev);
+        return 0;
+    }
+
+    return baudRate(steps[count > margin + 1u ? count - 1 - margin : 0]);
+}
+
 void W25QXX::configure() {
-    spi_init(_dev, BAUDRATE);
+    _baud = spi_init(_dev, _baud);
     spi_set_format(_dev, 8, CPOL, CPHA, SPI_MSB_FIRST);
 
     gpio_set_function(_clk, GPIO_FUNC_SPI);
@@ -150,6 +223,11 @@ void W25QXX::configure() {
 
 void W25QXX::select() {
     if ((_sel++) == 0) {
+        // --> other devices on the bus may have changed the baud-rate.
+        if (spi_get_baudrate(_dev) != _baud) {
+            spi_set_baudrate(_dev, _baud);
+        }
+
         gpio_put(_csn, 0);
     }
 }
@@ -60,6 +60,13 @@ private:
     static constexpr spi_cpol_t CPOL = SPI_CPOL_1;
     static constexpr spi_cpha_t CPHA = SPI_CPHA_1;
 
+    /**
+     * Clock calibration: starting baud-rate, bytes to verify and rounds per step.
+     */
+    static constexpr uint32_t CALIB_BAUDRATE = 1000 * 1000; // --> 1MHz.
+    static constexpr uint32_t CALIB_LEN = 64;
+    static constexpr uint32_t CALIB_ROUNDS = 4;
+
 private:
     spi_inst_t* _dev;
 
@@ -71,6 +78,7 @@ private:
 
     uint32_t _id;
     uint32_t _bcnt;
+    uint32_t _baud;
 
     /**
      * Note for SPI device:
@@ -143,6 +151,28 @@ public:
     inline bool fastMode(bool) { return false; }
 #endif
 
+    /**
+     * Calibrate the SPI baud-rate and returns the locked baud-rate, or 0 if failed.
+     * This doubles the baud-rate from CALIB_BAUDRATE up to `maxBaud`,
+     * verifies JEDEC ID and the reference bytes at `addr` (read at CALIB_BAUDRATE) on each step,
+     * and then locks in the fastest reliable one minus `margin` steps.
+     * Note that, `addr` should point non-blank data.
+     */
+    uint32_t calibrate(uint32_t addr = 0, uint32_t maxBaud = 62500000, uint8_t margin = 1);
+
+    /**
+     * Get the actual SPI baud-rate of this chip.
+     */
+    inline uint32_t baudRate() const {
+        return _baud;
+    }
+
+    /**
+     * Set the SPI baud-rate, e.g. restore the stored calibration result.
+     * Returns the actual baud-rate.
+     */
+    uint32_t baudRate(uint32_t baud);
+
     /**
      * Get the capacity of the flash.
      * This will be valid after calling `init()` method.
@@ -196,6 +226,10 @@ protected:
     void deselect();
 
 private:
+    /* read JEDEC ID and the reference bytes, and compare them. */
+    bool verify(uint32_t addr, const uint8_t* ref, uint32_t len);
+
+
     /* write data and read one byte. */
     uint8_t xfer(uint8_t data);
 
@@ -0,0 +1,214 @@
+#ifndef __W25QXX_WC_H__
+#define __W25QXX_WC_H__
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Describes a write-combining buffer for W25QXX flash drivers.
+ * this collects sequential small writes into a page buffer,
+ * and programs them with one page program per page.
+ * --
+ * `T` can be `w25qxx_t` (STM32) or `W25QXX` (RP2040).
+ * it only requires `read(addr, uint8_t*, len)` and `write(addr, const uint8_t*, len)`.
+ *
+ * note that, NOR flash programming can only clear bits.
+ * so, buffered bytes are merged as AND, and unwritten bytes are kept as 0xff,
+ * which leaves the flash cell untouched when the page is programmed.
+ */
+template<typename T, uint32_t page = 256>
+class w25qxx_wc_t {
+public:
+    static constexpr uint32_t PAGE_SIZE = page;
+    static constexpr uint32_t NONE = 0xffffffffu;
+
+private:
+    T& _dev;
+    uint32_t _page;             // --> buffered page, NONE if no page.
+    uint32_t _lo, _hi;          // --> dirty range, [lo, hi).
+    uint32_t _seq, _seq_seen;   // --> write sequence, for idle detection.
+    uint32_t _tick;             // --> tick when the last write observed.
+    uint32_t _timeout;          // --> idle timeout to flush.
+    uint8_t _buf[page];
+
+public:
+    /**
+     * initialize a new write-combining buffer on the flash driver.
+     * `timeout` is the idle time (in ticks of `poll`) to flush the buffer.
+     */
+    w25qxx_wc_t(T& dev, uint32_t timeout = 10)
+        : _dev(dev), _page(NONE), _lo(0), _hi(0),
+          _seq(0), _seq_seen(0), _tick(0), _timeout(timeout)
+    {
+    }
+
+    /* flush the buffer on destruction. */
+    ~w25qxx_wc_t() { flush(); }
+
+public:
+    /* get the driver. */
+    inline T& device() const { return _dev; }
+
+    /* test whether the buffer has unflushed bytes or not. */
+    inline bool dirty() const { return _lo != _hi; }
+
+    /* get the buffered page, or NONE. */
+    inline uint32_t buffered() const { return dirty() ? _page : NONE; }
+
+    /* set the idle timeout. */
+    inline void timeout(uint32_t timeout) { _timeout = timeout; }
+
+public:
+    /**
+     * write bytes into the buffer and returns buffered (or written) bytes.
+     * the page will be programmed when the write reached its end,
+     * or the write moved to another page.
+     */
+    uint32_t write(uint32_t addr, const void* buf, uint32_t len) {
+        const uint8_t* cursor = (const uint8_t*) buf;
+        uint32_t done = 0;
+
+        while (done < len) {
+            uint32_t pg = addr / PAGE_SIZE;
+            uint32_t offset = addr % PAGE_SIZE;
+            uint32_t slice = PAGE_SIZE - offset;
+
+            if (slice > len - done) {
+                slice = len - done;
+            }
+
+            if (pg != _page || !dirty()) {
+                if (!flush()) {
+                    break;
+                }
+
+                _page = pg;
+                _lo = _hi = offset;
+            }
+
+            merge(offset, cursor, slice);
+
+            // --> reached the end of page: program it now.
+            if (_hi >= PAGE_SIZE && !flush()) {
+                break;
+            }
+
+            addr += slice;
+            done += slice;
+            cursor += slice;
+        }
+
+        ++_seq;
+        return done;
+    }
+
+    /**
+     * read bytes from the flash, with unflushed bytes applied.
+     * the result is same with what the flash will have after flush.
+     */
+    uint32_t read(uint32_t addr, void* buf, uint32_t len) {
+        uint32_t ret = _dev.read(addr, (uint8_t*) buf, len);
+        if (!ret || !dirty()) {
+            return ret;
+        }
+
+        uint32_t lo = _page * PAGE_SIZE + _lo;
+        uint32_t hi = _page * PAGE_SIZE + _hi;
+
+        if (addr >= hi || addr + ret <= lo) {
+            return ret;
+        }
+
+        uint32_t from = addr > lo ? addr : lo;
+        uint32_t to = addr + ret < hi ? addr + ret : hi;
+        uint8_t* dst = (uint8_t*) buf + (from - addr);
+        const uint8_t* src = _buf + (from - _page * PAGE_SIZE);
+
+        for (uint32_t i = 0; i < to - from; ++i) {
+            dst[i] &= src[i];
+        }
+
+        return ret;
+    }
+
+    /**
+     * program the buffered bytes into the flash.
+     * returns false if the driver failed to write.
+     */
+    bool flush() {
+        if (!dirty()) {
+            return true;
+        }
+
+        uint32_t len = _hi - _lo;
+        uint32_t addr = _page * PAGE_SIZE + _lo;
+
+        if (_dev.write(addr, (const uint8_t*) (_buf + _lo), len) != len) {
+            return false;
+        }
+
+        discard();
+        return true;
+    }
+
+    /**
+     * drop the buffered bytes without programming.
+     * call this (or `flush`) before erasing the buffered page.
+     */
+    inline void discard() {
+        _page = NONE;
+        _lo = _hi = 0;
+    }
+
+    /**
+     * flush the buffer if no write has been made for `timeout`.
+     * call this periodically, e.g. poll(HAL_GetTick()).
+     */
+    bool poll(uint32_t now) {
+        if (!dirty()) {
+            return true;
+        }
+
+        if (_seq != _seq_seen) {
+            _seq_seen = _seq;
+            _tick = now;
+            return true;
+        }
+
+        if ((now - _tick) < _timeout) {
+            return true;
+        }
+
+        return flush();
+    }
+
+private:
+    /* merge bytes into the buffer, unwritten bytes are kept as 0xff. */
+    void merge(uint32_t offset, const uint8_t* src, uint32_t len) {
+        uint32_t end = offset + len;
+
+        if (_lo == _hi) {
+            memset(_buf + offset, 0xff, len);
+            _lo = offset;
+            _hi = end;
+        }
+
+        else {
+            if (offset < _lo) {
+                memset(_buf + offset, 0xff, _lo - offset);
+                _lo = offset;
+            }
+
+            if (end > _hi) {
+                memset(_buf + _hi, 0xff, end - _hi);
+                _hi = end;
+            }
+        }
+
+        for (uint32_t i = 0; i < len; ++i) {
+            _buf[offset + i] &= src[i];
+        }
+    }
+};
+
+#endif // __W25QXX_WC_H__